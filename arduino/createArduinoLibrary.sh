@@ -7,5 +7,29 @@ cp ../src/led_strip_no_backend.h .
 cp ../src/led_strip-cpp.h .
 cp ../src/led_strip-cpp-implementation.h .
 cp ../src/led_strip_struct.h .
+cp ../src/led_strip_snapshot.h .
+cp ../src/led_strip_snapshot.c led_strip_snapshot.cpp
+cp ../src/led_strip_pixel.h .
+cp ../src/led_strip_batch.h .
+cp ../src/led_strip_batch.c led_strip_batch.cpp
+cp ../src/led_strip_protocol.h .
+cp ../src/led_strip_protocol.c led_strip_protocol.cpp
+cp ../src/led_strip_interpolator.h .
+cp ../src/led_strip_interpolator.c led_strip_interpolator.cpp
+cp ../src/led_strip_view.h .
+cp ../src/led_strip_view.c led_strip_view.cpp
+cp ../src/led_strip_math.h .
+cp ../src/led_strip_math.c led_strip_math.cpp
+cp ../src/led_strip_arena.h .
+cp ../src/led_strip_arena.c led_strip_arena.cpp
+cp ../src/led_strip_power.h .
+cp ../src/led_strip_power_track.h .
+cp ../src/led_strip_power.c led_strip_power.cpp
+cp ../src/led_strip_particles.h .
+cp ../src/led_strip_particles.c led_strip_particles.cpp
+cp ../src/led_strip_calibration.h .
+cp ../src/led_strip_calibration.c led_strip_calibration.cpp
+cp ../src/led_strip_scatter.h .
+cp ../src/led_strip_scatter.c led_strip_scatter.cpp
 
 zip -r LedStrip.zip * -x createArduinoLibrary.sh
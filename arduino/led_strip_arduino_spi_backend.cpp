@@ -18,7 +18,9 @@ typedef struct led_strip_backend_arduino_spi_t {
 int led_strip_show_arduino_spi(led_strip_t * led_strip);
 void led_strip_destroy_arduino_spi(led_strip_t * led_strip);
 
-LedStripArduinoSpi::LedStripArduinoSpi(uint32_t frequency, uint32_t num_leds) : LedStrip(num_leds)
+LedStripArduinoSpi::LedStripArduinoSpi(uint32_t frequency, uint32_t num_leds,
+                                       const led_strip_protocol_t * protocol)
+    : LedStrip(num_leds, protocol)
 {
     // start the SPI library
     SPI.begin();
@@ -66,16 +68,12 @@ int led_strip_show_arduino_spi(led_strip_t * led_strip)
     SPI.beginTransaction(SPISettings(backend_data->frequency, MSBFIRST, SPI_MODE0));
 #endif
 
-    for (uint32_t i = 0; i < HEADER_LENGTH_IN_BYTES; i++) {
+    for (uint32_t i = 0; i < led_strip->header_len; i++) {
         SPI.transfer(led_strip->header_data[i]);
     }
 
-    for (uint32_t i = 0; i < led_strip->num_leds; i++) {
-        uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
-        SPI.transfer(ptr[0]);
-        SPI.transfer(ptr[1]);
-        SPI.transfer(ptr[2]);
-        SPI.transfer(ptr[3]);
+    for (uint32_t i = 0; i < led_strip->tx_len; i++) {
+        SPI.transfer(led_strip->tx_data[i]);
     }
 
     for (uint32_t i = 0; i < led_strip->footer_len; i++) {
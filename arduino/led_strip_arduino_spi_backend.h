@@ -11,9 +11,20 @@
 class LedStripArduinoSpi : public LedStrip
 {
 public:
-    LedStripArduinoSpi(uint32_t frequency, uint32_t num_leds);
+    LedStripArduinoSpi(uint32_t frequency, uint32_t num_leds,
+                       const led_strip_protocol_t * protocol = &led_strip_protocol_apa102);
 private:
 
 };
 
+// Arduino SPI strip created with the protocol of a chip, e.g.
+// LedStripArduinoSpiWith<LedStripHd107s>
+template <class Protocol>
+class LedStripArduinoSpiWith : public LedStripArduinoSpi
+{
+public:
+    LedStripArduinoSpiWith(uint32_t frequency, uint32_t num_leds)
+        : LedStripArduinoSpiWith::LedStripArduinoSpi(frequency, num_leds, Protocol::protocol()) {}
+};
+
 #endif
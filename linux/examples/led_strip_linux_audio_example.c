@@ -0,0 +1,86 @@
+/*
+@file led_strip_linux_audio_example.c
+
+@brief Drives a strip from audio. The input is a 16 bit PCM WAV file or an
+       ALSA capture device such as the loopback "hw:Loopback,1,0". The output
+       is a SPI device or, for testing without hardware, a file that captures
+       the stream that would have been sent.
+
+       Usage: led_strip_linux_audio_example input [output] [leds] [bands]
+*/
+#include "led_strip_linux_spi_backend.h"
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_audio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_SIZE 512
+#define SAMPLE_RATE 44100
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2) {
+        printf("Usage: %s input [output] [leds] [bands]\n", argv[0]);
+        return 1;
+    }
+
+    const char * input = argv[1];
+    const char * output = (argc > 2) ? argv[2] : "/dev/spidev1.0";
+    int leds = (argc > 3) ? atoi(argv[3]) : 300;
+    int bands = (argc > 4) ? atoi(argv[4]) : 16;
+
+    // Anything that is not a SPI device is treated as a capture file
+    led_strip_t * strip;
+    if (strncmp(output, "/dev/spidev", 11) == 0) {
+        strip = led_strip_create_linux_spi(output, 5000000, leds);
+    } else {
+        strip = led_strip_create_linux_file(output, 0, leds);
+    }
+
+    if (strip == NULL) {
+        return 1;
+    }
+
+    // WAV files play in real time when shown on a strip, and as fast as
+    // possible when captured to a file.
+    led_strip_audio_t * audio;
+    size_t length = strlen(input);
+    if (length > 4 && strcmp(input + length - 4, ".wav") == 0) {
+        int realtime = (strncmp(output, "/dev/spidev", 11) == 0);
+        audio = led_strip_audio_create_wav(strip, input, BLOCK_SIZE, bands, realtime);
+    } else {
+        audio = led_strip_audio_create_alsa(strip, input, SAMPLE_RATE, BLOCK_SIZE, bands);
+    }
+
+    if (audio == NULL) {
+        led_strip_destroy(strip);
+        return 1;
+    }
+
+    int ret;
+    while ((ret = led_strip_audio_process(audio)) == 0) {
+        // Each call waits for one block of audio
+    }
+
+    led_strip_audio_stats_t stats;
+    led_strip_audio_get_stats(audio, &stats);
+
+    printf("%llu blocks of %u us\n", (unsigned long long) stats.blocks, stats.block_us);
+    if (stats.blocks) {
+        printf("latency from block captured to shown: avg %.1f us, max %llu us\n",
+               (double) stats.total_latency_us / stats.blocks,
+               (unsigned long long) stats.max_latency_us);
+        printf("end to end including the block itself: avg %.1f us\n",
+               stats.block_us + (double) stats.total_latency_us / stats.blocks);
+    }
+
+    led_strip_audio_destroy(audio);
+
+    led_strip_clear(strip);
+    led_strip_show(strip);
+    led_strip_destroy(strip);
+
+    return (ret < 0) ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+/*
+@file led_strip_linux_math_bench.c
+
+@brief Compares the fixed point math in led_strip_math.h with the usual
+       float and divide versions, for speed and for the largest difference
+       in result. On a host with an FPU and a divider the gap is much smaller
+       than on an MCU, but the relative cost is still visible.
+
+       Usage: led_strip_linux_math_bench [rounds]
+*/
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_math.h"
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLES 4096
+#define LEDS 1024
+
+static uint8_t input_a[SAMPLES];
+static uint8_t input_b[SAMPLES];
+static uint8_t input_t[SAMPLES];
+static volatile uint32_t sink;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+// The naive versions, as effects are usually written
+static uint8_t naive_scale(uint8_t value, uint8_t scale)
+{
+    return (uint8_t) ((value * scale) / 255);
+}
+
+static uint8_t naive_blend(uint8_t a, uint8_t b, uint8_t amount)
+{
+    float t = amount / 255.0f;
+    return (uint8_t) (a * (1.0f - t) + b * t);
+}
+
+static uint8_t naive_sin(uint8_t theta)
+{
+    return (uint8_t) lroundf(128.0f + 127.0f * sinf(theta * (float) M_PI / 128.0f));
+}
+
+static uint8_t naive_ease(uint8_t t)
+{
+    float x = t / 255.0f;
+    float y = (x < 0.5f) ? 2 * x * x : 1 - 2 * (1 - x) * (1 - x);
+    return (uint8_t) (y * 255.0f);
+}
+
+static uint8_t naive_noise(uint16_t x)
+{
+    float position = x / 256.0f;
+    float cell = floorf(position);
+    float t = position - cell;
+    float a = led_strip_hash8((uint16_t) cell);
+    float b = led_strip_hash8((uint16_t) (cell + 1));
+    t = (t < 0.5f) ? 2 * t * t : 1 - 2 * (1 - t) * (1 - t);
+    return (uint8_t) (a + (b - a) * t);
+}
+
+typedef struct result_t {
+    double ns;
+    int max_error;
+} result_t;
+
+#define BENCH(result, expression, reference)                                \
+    do {                                                                    \
+        uint32_t sum = 0;                                                   \
+        uint64_t start = now_ns();                                          \
+        for (uint32_t round = 0; round < rounds; round++) {                 \
+            for (uint32_t i = 0; i < SAMPLES; i++) {                        \
+                uint8_t a = input_a[i], b = input_b[i], t = input_t[i];    \
+                (void) a; (void) b; (void) t;                               \
+                sum += (expression);                                        \
+            }                                                               \
+        }                                                                   \
+        (result).ns = (double) (now_ns() - start) / ((double) rounds * SAMPLES); \
+        sink = sum;                                                         \
+        (result).max_error = 0;                                             \
+        for (uint32_t i = 0; i < SAMPLES; i++) {                            \
+            uint8_t a = input_a[i], b = input_b[i], t = input_t[i];        \
+            (void) a; (void) b; (void) t;                                   \
+            int error = abs((int) (expression) - (int) (reference));        \
+            if (error > (result).max_error) {                               \
+                (result).max_error = error;                                 \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+static void print_result(const char * name, result_t naive, result_t fixed)
+{
+    printf("%-8s %10.2f %10.2f %8.2fx", name, naive.ns, fixed.ns, naive.ns / fixed.ns);
+    if (fixed.max_error >= 0) {
+        printf(" %10d\n", fixed.max_error);
+    } else {
+        printf(" %10s\n", "-");
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t rounds = (argc > 1) ? (uint32_t) atoi(argv[1]) : 2000;
+    result_t naive, fixed;
+
+    srand(1);
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        input_a[i] = (uint8_t) rand();
+        input_b[i] = (uint8_t) rand();
+        input_t[i] = (uint8_t) rand();
+    }
+
+    printf("%-8s %10s %10s %9s %10s\n", "", "naive ns", "fixed ns", "speedup", "max error");
+
+    BENCH(naive, naive_scale(a, t), naive_scale(a, t));
+    BENCH(fixed, led_strip_scale8(a, t), naive_scale(a, t));
+    print_result("scale8", naive, fixed);
+
+    BENCH(naive, naive_blend(a, b, t), naive_blend(a, b, t));
+    BENCH(fixed, led_strip_blend8(a, b, t), naive_blend(a, b, t));
+    print_result("blend8", naive, fixed);
+
+    BENCH(naive, naive_sin(a), naive_sin(a));
+    BENCH(fixed, led_strip_sin8(a), naive_sin(a));
+    print_result("sin8", naive, fixed);
+
+    BENCH(naive, naive_ease(t), naive_ease(t));
+    BENCH(fixed, led_strip_ease8(t), naive_ease(t));
+    print_result("ease8", naive, fixed);
+
+    BENCH(naive, naive_noise((uint16_t) (a << 8 | t)), naive_noise((uint16_t) (a << 8 | t)));
+    BENCH(fixed, led_strip_noise8((uint16_t) (a << 8 | t)), naive_noise((uint16_t) (a << 8 | t)));
+    print_result("noise8", naive, fixed);
+
+    // Fading a whole strip pixel by pixel against the range function
+    led_strip_t * strip = led_strip_create_linux_file("/dev/null", 0, LEDS);
+    if (strip == NULL) {
+        return 1;
+    }
+    led_strip_set_color(strip, 200, 100, 50);
+
+    uint64_t start = now_ns();
+    for (uint32_t round = 0; round < rounds / 16; round++) {
+        for (uint32_t p = 0; p < LEDS; p++) {
+            uint8_t r, g, b;
+            led_strip_get_pixel_color_and_brightness(strip, p, &r, &g, &b, NULL);
+            led_strip_set_pixel_color(strip, p, naive_scale(r, 250),
+                                      naive_scale(g, 250), naive_scale(b, 250));
+        }
+    }
+    naive.ns = (double) (now_ns() - start) / ((double) (rounds / 16) * LEDS);
+
+    start = now_ns();
+    for (uint32_t round = 0; round < rounds / 16; round++) {
+        led_strip_scale_range(strip, 0, LEDS, 250);
+    }
+    fixed.ns = (double) (now_ns() - start) / ((double) (rounds / 16) * LEDS);
+    fixed.max_error = -1;
+    print_result("fade/px", naive, fixed);
+
+    led_strip_destroy(strip);
+
+    return 0;
+}
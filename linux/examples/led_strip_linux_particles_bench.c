@@ -0,0 +1,165 @@
+/*
+@file led_strip_linux_particles_bench.c
+
+@brief Compares the particle system in led_strip_particles.h with particles
+       kept as an array of structs and drawn one at a time with the get and
+       set pixel functions, as effects are usually written. Both do the same
+       fixed point physics and draw every particle across two LEDs.
+
+       Usage: led_strip_linux_particles_bench [leds] [frames]
+*/
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_particles.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+typedef struct particle_t {
+    int32_t position;
+    int32_t velocity;
+    uint16_t life;
+    uint8_t r, g, b;
+    uint8_t level;
+} particle_t;
+
+#define GRAVITY -2
+#define DRAG 254
+#define FADE 250
+
+static uint8_t add8(uint8_t a, uint16_t b)
+{
+    return (uint8_t) ((a + b > 255) ? 255 : a + b);
+}
+
+static void naive_add(led_strip_t * strip, uint32_t p, uint16_t r, uint16_t g, uint16_t b)
+{
+    uint8_t old_r, old_g, old_b;
+    led_strip_get_pixel_color_and_brightness(strip, p, &old_r, &old_g, &old_b, NULL);
+    led_strip_set_pixel_color(strip, p, add8(old_r, r), add8(old_g, g), add8(old_b, b));
+}
+
+static void naive_spawn(particle_t * particle, uint32_t leds)
+{
+    particle->position = (int32_t) ((uint32_t) rand() % (leds * LED_STRIP_PARTICLE_ONE));
+    particle->velocity = rand() % 1024 - 512;
+    particle->life = (uint16_t) (50 + rand() % 200);
+    particle->r = (uint8_t) rand();
+    particle->g = (uint8_t) rand();
+    particle->b = (uint8_t) rand();
+    particle->level = 255;
+}
+
+static void naive_frame(led_strip_t * strip, particle_t * particles, uint32_t count, uint32_t leds)
+{
+    int32_t end = (int32_t) (leds * LED_STRIP_PARTICLE_ONE);
+
+    for (uint32_t i = 0; i < count; i++) {
+        particle_t * particle = &particles[i];
+
+        particle->velocity = (particle->velocity + GRAVITY) * (DRAG + 1) / 256;
+        particle->position += particle->velocity;
+        particle->level = (uint8_t) ((particle->level * (FADE + 1)) >> 8);
+        if (particle->life > 0) {
+            particle->life--;
+        }
+        if (particle->position < 0 || particle->position >= end ||
+            particle->life == 0 || particle->level == 0) {
+            naive_spawn(particle, leds);
+        }
+
+        uint32_t led = (uint32_t) particle->position / LED_STRIP_PARTICLE_ONE;
+        uint16_t next = (uint16_t) ((uint32_t) particle->position % LED_STRIP_PARTICLE_ONE);
+        uint16_t here = (uint16_t) (LED_STRIP_PARTICLE_ONE - next);
+        uint16_t r = (uint16_t) ((particle->r * (particle->level + 1)) >> 8);
+        uint16_t g = (uint16_t) ((particle->g * (particle->level + 1)) >> 8);
+        uint16_t b = (uint16_t) ((particle->b * (particle->level + 1)) >> 8);
+
+        naive_add(strip, led, (r * here) >> 8, (g * here) >> 8, (b * here) >> 8);
+        if (led + 1 < leds) {
+            naive_add(strip, led + 1, (r * next) >> 8, (g * next) >> 8, (b * next) >> 8);
+        }
+    }
+}
+
+static void engine_refill(led_strip_particles_t * particles, uint32_t count, uint32_t leds)
+{
+    while (led_strip_particles_count(particles) < count) {
+        led_strip_particles_spawn(particles,
+                                  (int32_t) ((uint32_t) rand() % (leds * LED_STRIP_PARTICLE_ONE)),
+                                  rand() % 1024 - 512,
+                                  (uint8_t) rand(), (uint8_t) rand(), (uint8_t) rand(),
+                                  (uint16_t) (50 + rand() % 200));
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t leds = (argc > 1) ? (uint32_t) atoi(argv[1]) : 1000;
+    uint32_t frames = (argc > 2) ? (uint32_t) atoi(argv[2]) : 200;
+    const uint32_t counts[] = { 100, 1000, 10000, 50000 };
+
+    led_strip_t * strip = led_strip_create_linux_file("/dev/null", 0, leds);
+    if (strip == NULL) {
+        return 1;
+    }
+
+    printf("%u LEDs, %u frames\n", leds, frames);
+    printf("%9s %14s %14s %8s\n", "particles", "naive p/ms", "engine p/ms", "speedup");
+
+    for (uint32_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        uint32_t count = counts[c];
+        particle_t * naive = (particle_t *) malloc(count * sizeof(particle_t));
+        led_strip_particles_t * particles = led_strip_particles_create(count, leds);
+        if (naive == NULL || particles == NULL) {
+            return 1;
+        }
+        led_strip_particles_set_forces(particles, GRAVITY, DRAG, FADE);
+
+        srand(1);
+        for (uint32_t i = 0; i < count; i++) {
+            naive_spawn(&naive[i], leds);
+        }
+        // Clearing the strip costs the same for both, so it isn't counted
+        uint64_t naive_ns = 0;
+        for (uint32_t f = 0; f < frames; f++) {
+            led_strip_clear(strip);
+            uint64_t start = now_ns();
+            naive_frame(strip, naive, count, leds);
+            naive_ns += now_ns() - start;
+        }
+
+        srand(1);
+        uint64_t engine_ns = 0;
+        for (uint32_t f = 0; f < frames; f++) {
+            led_strip_clear(strip);
+            uint64_t start = now_ns();
+            engine_refill(particles, count, leds);
+            led_strip_particles_update(particles);
+            led_strip_particles_render(particles, strip);
+            engine_ns += now_ns() - start;
+        }
+
+        double naive_ms = naive_ns / 1e6;
+        double engine_ms = engine_ns / 1e6;
+
+        double total = (double) count * frames;
+        printf("%9u %14.0f %14.0f %7.2fx\n", count, total / naive_ms, total / engine_ms,
+               naive_ms / engine_ms);
+
+        led_strip_particles_destroy(particles);
+        free(naive);
+    }
+
+    led_strip_show(strip);
+    led_strip_destroy(strip);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+@file led_strip_linux_render_bench.c
+
+@brief Measures how rendering a large strip scales with the number of
+       threads. The kernel draws a Mandelbrot set across a virtual matrix, so
+       the cost per pixel is very uneven and the threads have to steal work
+       from each other to finish together.
+
+       Usage: led_strip_linux_render_bench [leds] [frames] [max_threads]
+*/
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_render.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define WIDTH 1000
+#define MAX_ITERATIONS 64
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+typedef struct frame_t {
+    uint32_t height;
+    float zoom;
+} frame_t;
+
+static void mandelbrot(led_strip_t * strip, uint32_t first, uint32_t count, void * arg)
+{
+    const frame_t * frame = (const frame_t *) arg;
+
+    for (uint32_t p = first; p < first + count; p++) {
+        float cx = ((float) (p % WIDTH) / WIDTH * 3.0f - 2.0f) * frame->zoom - 0.5f * (1.0f - frame->zoom);
+        float cy = ((float) (p / WIDTH) / frame->height * 2.4f - 1.2f) * frame->zoom;
+        float x = 0, y = 0;
+        int i = 0;
+
+        while (i < MAX_ITERATIONS && x * x + y * y < 4.0f) {
+            float t = x * x - y * y + cx;
+            y = 2 * x * y + cy;
+            x = t;
+            i++;
+        }
+
+        led_strip_set_pixel_color_and_brightness(strip, p, (uint8_t) (i * 4),
+                                                 (uint8_t) (i * 2), (uint8_t) (255 - i * 4), 31);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t leds = (argc > 1) ? (uint32_t) atoi(argv[1]) : 500000;
+    uint32_t frames = (argc > 2) ? (uint32_t) atoi(argv[2]) : 20;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t max_threads = (argc > 3) ? (uint32_t) atoi(argv[3]) : (uint32_t) (cpus > 0 ? cpus : 1);
+
+    led_strip_t * strip = led_strip_create_linux_file("/dev/null", 0, leds);
+    if (strip == NULL) {
+        return 1;
+    }
+
+    frame_t frame;
+    frame.height = (leds + WIDTH - 1) / WIDTH;
+
+    printf("%u pixels, %u frames, %ld CPUs\n", leds, frames, cpus);
+    printf("threads  ms/frame      fps  speedup  efficiency  steals/frame\n");
+
+    double single_ms = 0;
+    for (uint32_t threads = 1; threads <= max_threads; threads++) {
+        led_strip_render_t * render = led_strip_render_create(threads);
+        if (render == NULL) {
+            return 1;
+        }
+
+        uint64_t start = now_ns();
+        for (uint32_t f = 0; f < frames; f++) {
+            frame.zoom = 1.0f - 0.5f * f / frames;
+            led_strip_render_run(render, strip, &mandelbrot, &frame);
+        }
+        double ms = (now_ns() - start) / 1e6 / frames;
+
+        led_strip_render_stats_t stats;
+        led_strip_render_get_stats(render, &stats);
+        led_strip_render_destroy(render);
+
+        if (threads == 1) {
+            single_ms = ms;
+        }
+        printf("%7u %9.2f %8.1f %8.2f %10.0f%% %13.1f\n", threads, ms, 1000.0 / ms,
+               single_ms / ms, 100.0 * single_ms / ms / threads,
+               (double) stats.steals / stats.frames);
+    }
+
+    led_strip_show(strip);
+    led_strip_destroy(strip);
+
+    return 0;
+}
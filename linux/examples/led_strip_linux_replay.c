@@ -0,0 +1,131 @@
+/*
+@file led_strip_linux_replay.c
+
+@brief Replays a recording made with led_strip_linux_recorder.h on a strip at
+       its original timing, or decodes it and prints what changed per frame.
+
+       Options:
+         -o OUTPUT           SPI device or capture file to replay to. Without
+                             it the recording is only decoded.
+         -f HZ               SPI frequency, default 5000000
+         -x SPEED            Playback speed, default 1.0
+         -v                  Print every frame while decoding
+*/
+#include "led_strip_linux_spi_backend.h"
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_recorder.h"
+
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t when)
+{
+    struct timespec due;
+    due.tv_sec = (time_t) (when / 1000000000ULL);
+    due.tv_nsec = (long) (when % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR) {
+        // Interrupted by a signal, keep waiting
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const char * output = NULL;
+    uint32_t frequency = 5000000;
+    double speed = 1.0;
+    int verbose = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:f:x:v")) != -1) {
+        switch (opt) {
+        case 'o': output = optarg; break;
+        case 'f': frequency = (uint32_t) atoi(optarg); break;
+        case 'x': speed = atof(optarg); break;
+        case 'v': verbose = 1; break;
+        default:
+            speed = 0;
+        }
+    }
+
+    if (optind != argc - 1 || speed <= 0) {
+        printf("Usage: %s [-o OUTPUT] [-f HZ] [-x SPEED] [-v] RECORDING\n", argv[0]);
+        return 1;
+    }
+
+    led_strip_recording_t * recording = led_strip_recording_open(argv[optind]);
+    if (recording == NULL) {
+        return 1;
+    }
+    uint32_t num_leds = led_strip_recording_num_leds(recording);
+
+    // Send with the protocol of the recorded strip
+    const led_strip_protocol_t * protocol = led_strip_recording_protocol(recording);
+    if (protocol == NULL) {
+        fprintf(stderr, "Recorded with an unknown protocol, replaying as APA102\n");
+        protocol = &led_strip_protocol_apa102;
+    }
+
+    led_strip_t * strip = NULL;
+    if (output && strncmp(output, "/dev/spidev", 11) == 0) {
+        strip = led_strip_create_linux_spi_protocol(output, frequency, num_leds, protocol);
+    } else if (output) {
+        strip = led_strip_create_linux_file_protocol(output, frequency, num_leds, protocol);
+    }
+    if (output && strip == NULL) {
+        led_strip_recording_close(recording);
+        return 1;
+    }
+
+    uint64_t frames = 0, changed_total = 0, time_us = 0;
+    uint64_t start_ns = now_ns();
+    uint32_t changed;
+    int ret;
+
+    while ((ret = led_strip_recording_next(recording, &time_us, &changed)) > 0) {
+        frames++;
+        changed_total += changed;
+
+        if (strip) {
+            sleep_until_ns(start_ns + (uint64_t) (time_us * 1000.0 / speed));
+            led_strip_recording_apply(recording, strip);
+            led_strip_show(strip);
+        } else if (verbose) {
+            printf("%10.3f s  %8u changed\n", time_us / 1e6, changed);
+        }
+    }
+
+    if (ret < 0) {
+        fprintf(stderr, "Recording is corrupt after frame %llu\n", (unsigned long long) frames);
+    }
+
+    fprintf(stderr, "%llu frames of %u %s LEDs over %.1f s, %.1f LEDs changed per frame\n",
+            (unsigned long long) frames, num_leds, protocol->name, time_us / 1e6,
+            frames ? (double) changed_total / frames : 0.0);
+
+    // Compare with storing every frame in full
+    struct stat info;
+    if (stat(argv[optind], &info) == 0 && frames > 0) {
+        double full = (double) frames * num_leds * sizeof(uint32_t);
+        fprintf(stderr, "%lld bytes, %.1f%% of the frames stored in full\n",
+                (long long) info.st_size, 100.0 * (double) info.st_size / full);
+    }
+
+    led_strip_recording_close(recording);
+    if (strip) {
+        led_strip_destroy(strip);
+    }
+
+    return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+/*
+@file led_strip_linux_rt_latency.c
+
+@brief Measures show latency with and without the real-time configuration.
+       Frames are written to /dev/null at a simulated SPI rate so no hardware
+       is needed. Background threads fault in memory to load the system.
+
+       Both paths report how long the caller was blocked in show and how long
+       it took from show until the frame was completely on the wire. Without
+       the real-time configuration the two are the same, as show sends the
+       frame itself. With it, the time to the wire comes from the counters of
+       the transmit thread.
+
+       Usage: led_strip_linux_rt_latency [load_threads] [frames] [chip]
+       chip is apa102, sk9822, hd107s or ws2801.
+       Run as root to get SCHED_FIFO priority and locked memory.
+*/
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_rt.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <strings.h> // for strcasecmp
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define LEDS 300
+#define FREQUENCY_HZ 5000000
+#define FRAME_PERIOD_NS 5000000
+#define LOAD_BYTES (16 * 1024 * 1024)
+
+static volatile int stop_load = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+// Keep the kernel busy with page faults and the CPU busy with copies
+static void * load_thread(void * arg)
+{
+    (void) arg;
+    while (!stop_load) {
+        uint8_t * mem = (uint8_t *) mmap(NULL, LOAD_BYTES, PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            continue;
+        }
+        for (size_t i = 0; i < LOAD_BYTES; i += 4096) {
+            mem[i] = (uint8_t) i;
+        }
+        munmap(mem, LOAD_BYTES);
+    }
+    return NULL;
+}
+
+static int compare_u64(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static void print_row(const char * name, uint64_t * samples, int count,
+                      uint64_t wire_total_ns, uint64_t wire_max_ns, uint64_t wire_frames)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += samples[i];
+    }
+    qsort(samples, count, sizeof(uint64_t), &compare_u64);
+
+    printf("  %-10s %8.1f %8.1f %8.1f   %8.1f %8.1f\n", name,
+           total / 1000.0 / count,
+           samples[(count * 99) / 100] / 1000.0,
+           samples[count - 1] / 1000.0,
+           wire_total_ns / 1000.0 / wire_frames,
+           wire_max_ns / 1000.0);
+}
+
+// Show frames at a fixed rate and record how long each show call took
+static void run(led_strip_t * strip, uint64_t * samples, int frames)
+{
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (int i = 0; i < frames; i++) {
+        next.tv_nsec += FRAME_PERIOD_NS;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+            // Interrupted by a signal, keep waiting
+        }
+
+        led_strip_set_color(strip, (uint8_t) i, 0, (uint8_t) ~i);
+
+        uint64_t start = now_ns();
+        led_strip_show(strip);
+        samples[i] = now_ns() - start;
+    }
+}
+
+static const led_strip_protocol_t * find_protocol(const char * name)
+{
+    const led_strip_protocol_t * protocols[] = {
+        &led_strip_protocol_apa102, &led_strip_protocol_sk9822,
+        &led_strip_protocol_hd107s, &led_strip_protocol_ws2801
+    };
+
+    for (size_t i = 0; i < sizeof(protocols) / sizeof(protocols[0]); i++) {
+        if (strcasecmp(name, protocols[i]->name) == 0) {
+            return protocols[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char ** argv)
+{
+    int load_threads = (argc > 1) ? atoi(argv[1]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int frames = (argc > 2) ? atoi(argv[2]) : 2000;
+    const led_strip_protocol_t * protocol = (argc > 3) ? find_protocol(argv[3])
+                                                       : &led_strip_protocol_apa102;
+
+    if (protocol == NULL || frames < 1) {
+        printf("Usage: %s [load_threads] [frames] [apa102|sk9822|hd107s|ws2801]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t * samples = (uint64_t *) malloc(frames * sizeof(uint64_t));
+    pthread_t * load = (pthread_t *) malloc(load_threads * sizeof(pthread_t));
+
+    if (samples == NULL || load == NULL) {
+        free(load);
+        free(samples);
+        return 1;
+    }
+
+    // The bytes a frame of this chip takes on the wire: start frame, pixels
+    // and end frame, as the file backend writes them
+    uint64_t frame_bytes = protocol->header_len + (uint64_t) LEDS * protocol->bytes_per_pixel +
+                           protocol->footer_len(LEDS);
+    uint64_t bus_ns = (frame_bytes * 8 * 1000000000ULL) / FREQUENCY_HZ;
+
+    for (int i = 0; i < load_threads; i++) {
+        pthread_create(&load[i], NULL, &load_thread, NULL);
+    }
+
+    printf("%d %s LEDs at %d Hz, %d frames, %d load threads, ideal bus time %.1f us\n",
+           LEDS, protocol->name, FREQUENCY_HZ, frames, load_threads, bus_ns / 1000.0);
+    printf("  %-10s %26s   %17s\n", "", "blocked in show (us)", "show to wire (us)");
+    printf("  %-10s %8s %8s %8s   %8s %8s\n", "", "avg", "p99", "max", "avg", "max");
+
+    // Before: the caller sends every frame itself, so show returns once the
+    // frame is on the wire
+    led_strip_t * strip = led_strip_create_linux_file_protocol("/dev/null", FREQUENCY_HZ,
+                                                               LEDS, protocol);
+    if (strip == NULL) {
+        return 1;
+    }
+    run(strip, samples, frames);
+    led_strip_destroy(strip);
+
+    uint64_t total = 0;
+    uint64_t max = 0;
+    for (int i = 0; i < frames; i++) {
+        total += samples[i];
+        max = (samples[i] > max) ? samples[i] : max;
+    }
+    print_row("default", samples, frames, total, max, (uint64_t) frames);
+
+    // After: a locked, pinned SCHED_FIFO thread sends the frames
+    led_strip_linux_rt_config_t config;
+    config.lock_memory = 1;
+    config.priority = 80;
+    config.cpu = (int) sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+    strip = led_strip_create_linux_rt(
+        led_strip_create_linux_file_protocol("/dev/null", FREQUENCY_HZ, LEDS, protocol), &config);
+    if (strip == NULL) {
+        // Locking memory and the priority need root or higher limits
+        config.lock_memory = 0;
+        config.priority = 0;
+        printf("Measuring without locked memory and real-time priority.\n");
+        strip = led_strip_create_linux_rt(
+            led_strip_create_linux_file_protocol("/dev/null", FREQUENCY_HZ, LEDS, protocol),
+            &config);
+    }
+    if (strip == NULL) {
+        return 1;
+    }
+    run(strip, samples, frames);
+
+    // Showing once more waits for the last measured frame to be sent
+    led_strip_show(strip);
+
+    led_strip_linux_rt_stats_t stats;
+    led_strip_linux_rt_get_stats(strip, &stats);
+    led_strip_destroy(strip);
+
+    print_row("real-time", samples, frames,
+              stats.total_latency_ns, stats.max_latency_ns, stats.frames);
+    printf("  transmit thread: wakeup avg %.1f us max %.1f us, send avg %.1f us max %.1f us, "
+           "%llu errors in %llu frames\n",
+           stats.total_wakeup_ns / 1000.0 / stats.frames, stats.max_wakeup_ns / 1000.0,
+           stats.total_transfer_ns / 1000.0 / stats.frames, stats.max_transfer_ns / 1000.0,
+           (unsigned long long) stats.errors, (unsigned long long) stats.frames);
+
+    stop_load = 1;
+    for (int i = 0; i < load_threads; i++) {
+        pthread_join(load[i], NULL);
+    }
+
+    free(load);
+    free(samples);
+    return 0;
+}
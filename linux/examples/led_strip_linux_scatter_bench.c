@@ -0,0 +1,107 @@
+/*
+@file led_strip_linux_scatter_bench.c
+
+@brief Compares setting a few random pixels of a large strip one call at a
+       time with led_strip_scatter, unsorted and sorted, at several fractions
+       of the strip changing per frame.
+
+       Usage: led_strip_linux_scatter_bench [leds] [frames]
+*/
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_scatter.h"
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t leds = (argc > 1) ? (uint32_t) atoi(argv[1]) : 500000;
+    uint32_t frames = (argc > 2) ? (uint32_t) atoi(argv[2]) : 50;
+    const double fractions[] = { 0.0001, 0.001, 0.01, 0.1, 0.5 };
+
+    led_strip_t * strip = led_strip_create_linux_file("/dev/null", 0, leds);
+    if (strip == NULL) {
+        return 1;
+    }
+
+    printf("%u LEDs, %u frames, ns per update\n", leds, frames);
+    printf("%9s %9s %10s %10s %10s\n", "changed", "updates", "per call", "scatter", "sorted");
+
+    for (uint32_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); f++) {
+        uint32_t count = (uint32_t) (leds * fractions[f]);
+        if (count == 0) {
+            count = 1;
+        }
+
+        // A new random set of pixels for every frame, like sensor events
+        led_strip_update_t * updates = (led_strip_update_t *)
+            malloc((size_t) frames * count * sizeof(led_strip_update_t));
+        led_strip_update_t * work = (led_strip_update_t *) malloc(count * sizeof(led_strip_update_t));
+        led_strip_update_t * scratch = (led_strip_update_t *) malloc(count * sizeof(led_strip_update_t));
+        if (updates == NULL || work == NULL || scratch == NULL) {
+            return 1;
+        }
+        srand(1);
+        for (size_t i = 0; i < (size_t) frames * count; i++) {
+            updates[i].p = (uint32_t) rand() % leds;
+            updates[i].r = (uint8_t) rand();
+            updates[i].g = (uint8_t) rand();
+            updates[i].b = (uint8_t) rand();
+            updates[i].brightness = PIXEL_MAX_BRIGHTNESS;
+        }
+
+        // Warm up the caches with the last frame, so the first method timed
+        // is not slowed down by the frames before
+        led_strip_scatter(strip, &updates[(size_t) (frames - 1) * count], count, NULL, NULL);
+
+        uint64_t start = now_ns();
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            const led_strip_update_t * frame_updates = &updates[(size_t) frame * count];
+            for (uint32_t i = 0; i < count; i++) {
+                led_strip_set_pixel_color_and_brightness(strip, frame_updates[i].p,
+                                                         frame_updates[i].r, frame_updates[i].g,
+                                                         frame_updates[i].b,
+                                                         frame_updates[i].brightness);
+            }
+        }
+        double per_call_ns = (double) (now_ns() - start) / ((double) frames * count);
+
+        start = now_ns();
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            led_strip_scatter(strip, &updates[(size_t) frame * count], count, NULL, NULL);
+        }
+        double scatter_ns = (double) (now_ns() - start) / ((double) frames * count);
+
+        // Sorting reorders the updates, so every frame sorts a fresh copy.
+        // The copy is timed too, as a caller that keeps its list would copy.
+        start = now_ns();
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            const led_strip_update_t * frame_updates = &updates[(size_t) frame * count];
+            for (uint32_t i = 0; i < count; i++) {
+                work[i] = frame_updates[i];
+            }
+            led_strip_scatter(strip, work, count, scratch, NULL);
+        }
+        double sorted_ns = (double) (now_ns() - start) / ((double) frames * count);
+
+        printf("%8.2f%% %9u %10.2f %10.2f %10.2f\n", fractions[f] * 100, count,
+               per_call_ns, scatter_ns, sorted_ns);
+
+        free(scratch);
+        free(work);
+        free(updates);
+    }
+
+    led_strip_show(strip);
+    led_strip_destroy(strip);
+
+    return 0;
+}
@@ -6,14 +6,26 @@
 #define BUILD_LED_STRIP_LINUX_SPI_BACKEND
 
 #include "led_strip_linux_spi_backend.h"
+#include "led_strip_interpolator.h"
+#include "led_strip_math.h"
 
 // compile with -std=gnu99
 #include <time.h>
 #include <stdio.h>
 
+// Clock for the interpolator
+static uint32_t clock_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t) (now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
 int main()
 {
     // Test 0: pulsating strip
+    // Test 1: moving block
+    // Test 2: pulsating strip rendered at 30 fps and interpolated
     int test = 0;
     
     int repeat = 0; // How many times to repeat the test. 0 is infinite
@@ -42,6 +54,10 @@ int main()
     uint8_t back_g = 0;
     uint8_t back_b = 255;
 
+    // Test 2 vars
+    uint32_t keyframe_interval_us = 33333;
+    led_strip_interpolator_t * interpolator = NULL;
+
     // Initialize led strip
     led_strip_t * strip = led_strip_create_linux_spi("/dev/spidev1.0", 5000000, leds);
     
@@ -57,6 +73,9 @@ int main()
         }
         led_strip_show(strip);
         break;
+    case 2:
+        interpolator = led_strip_interpolator_create(strip);
+        break;
     }
     
     
@@ -65,9 +84,9 @@ int main()
         case 0:
             for (int i = 0; i < UINT8_MAX; i+=increment)
             {
-                int r = (i * strip_r)/UINT8_MAX;
-                int g = (i * strip_g)/UINT8_MAX;
-                int b = (i * strip_b)/UINT8_MAX;
+                int r = led_strip_scale8(strip_r, i);
+                int g = led_strip_scale8(strip_g, i);
+                int b = led_strip_scale8(strip_b, i);
                 
                 led_strip_set_color(strip, r, g, b);
                 led_strip_show(strip);
@@ -75,9 +94,9 @@ int main()
             }
             for (int i = UINT8_MAX; i >= 0; i-=increment)
             {
-                int r = (i * strip_r)/UINT8_MAX;
-                int g = (i * strip_g)/UINT8_MAX;
-                int b = (i * strip_b)/UINT8_MAX;
+                int r = led_strip_scale8(strip_r, i);
+                int g = led_strip_scale8(strip_g, i);
+                int b = led_strip_scale8(strip_b, i);
                 
                 led_strip_set_color(strip, r, g, b);
                 led_strip_show(strip);
@@ -98,6 +117,21 @@ int main()
                 nanosleep(&tim, NULL);
             }
             break;
+        case 2:
+            // Only 30 keyframes per second are rendered, the interpolator
+            // shows as many frames in between as the bus allows.
+            for (int i = 0; i < 2 * UINT8_MAX; i += 8 * increment)
+            {
+                int level = (i < UINT8_MAX) ? i : 2 * UINT8_MAX - i;
+                int r = led_strip_scale8(strip_r, level);
+                int g = led_strip_scale8(strip_g, level);
+                int b = led_strip_scale8(strip_b, level);
+
+                led_strip_set_color(strip, r, g, b);
+                led_strip_interpolator_push_keyframe(interpolator);
+                led_strip_interpolator_show(interpolator, keyframe_interval_us, &clock_us);
+            }
+            break;
         default:
             printf("Invalid test %d\n", test);
         }
@@ -109,6 +143,10 @@ int main()
         }
     } while(repeat);
 
+    if (interpolator) {
+        led_strip_interpolator_destroy(interpolator);
+    }
+
     led_strip_clear(strip);
     led_strip_show(strip);
     led_strip_destroy(strip);
@@ -0,0 +1,283 @@
+/*
+@file led_strip_linux_video.c
+
+@brief Plays raw RGB24 video on a strip or matrix, for example
+       ffmpeg -i in.mp4 -f rawvideo -pix_fmt rgb24 -s 64x36 - | \
+           led_strip_linux_video -w 64 -h 36 -r 30 -m 32x18
+
+       Every LED samples one source pixel through a map computed at start.
+       Frames are shown at the source frame rate, and frames the bus can't
+       keep up with are dropped and counted.
+
+       Options:
+         -w WIDTH -h HEIGHT  Source frame size (required)
+         -r FPS              Source frame rate, default 30
+         -i FILE             Input, default stdin
+         -o OUTPUT           SPI device or capture file, default /dev/spidev1.0
+         -f HZ               SPI frequency, default 5000000
+         -p PROTOCOL         apa102, sk9822, hd107s or ws2801, default apa102
+         -l LEDS             A single strip across the middle row, default 300
+         -m COLSxROWS        A matrix wired row by row
+         -z                  The matrix rows are wired in a zigzag
+         -b BRIGHTNESS       Brightness 0-31, default 31
+         -R RECORDING        Also record the shown frames, see led_strip_linux_replay
+*/
+#include "led_strip_linux_spi_backend.h"
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_recorder.h"
+
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t when)
+{
+    struct timespec due;
+    due.tv_sec = (time_t) (when / 1000000000ULL);
+    due.tv_nsec = (long) (when % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR) {
+        // Interrupted by a signal, keep waiting
+    }
+}
+
+// Read a whole frame straight into buf. Returns 0 at the end of the input.
+static int read_frame(int fd, uint8_t * buf, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t ret = read(fd, buf + done, size - done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return 0;
+        }
+        done += (size_t) ret;
+    }
+    return 1;
+}
+
+// NULL for a name that is not known
+static const led_strip_protocol_t * find_protocol(const char * name)
+{
+    if (strcmp(name, "apa102") == 0) {
+        return &led_strip_protocol_apa102;
+    } else if (strcmp(name, "sk9822") == 0) {
+        return &led_strip_protocol_sk9822;
+    } else if (strcmp(name, "hd107s") == 0) {
+        return &led_strip_protocol_hd107s;
+    } else if (strcmp(name, "ws2801") == 0) {
+        return &led_strip_protocol_ws2801;
+    }
+    return NULL;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t width = 0, height = 0;
+    double fps = 30.0;
+    const char * input = NULL;
+    const char * output = "/dev/spidev1.0";
+    uint32_t frequency = 5000000;
+    const led_strip_protocol_t * protocol = &led_strip_protocol_apa102;
+    uint32_t cols = 300, rows = 1;
+    int zigzag = 0;
+    uint8_t brightness = PIXEL_MAX_BRIGHTNESS;
+    const char * recording = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:h:r:i:o:f:p:l:m:zb:R:")) != -1) {
+        switch (opt) {
+        case 'w': width = (uint32_t) atoi(optarg); break;
+        case 'h': height = (uint32_t) atoi(optarg); break;
+        case 'r': fps = atof(optarg); break;
+        case 'i': input = optarg; break;
+        case 'o': output = optarg; break;
+        case 'f': frequency = (uint32_t) atoi(optarg); break;
+        case 'p':
+            protocol = find_protocol(optarg);
+            if (protocol == NULL) {
+                printf("Unknown protocol %s.\n", optarg);
+            }
+            break;
+        case 'l': cols = (uint32_t) atoi(optarg); rows = 1; break;
+        case 'm':
+            if (sscanf(optarg, "%ux%u", &cols, &rows) != 2) {
+                cols = 0;
+            }
+            break;
+        case 'z': zigzag = 1; break;
+        case 'b': brightness = (uint8_t) atoi(optarg); break;
+        case 'R': recording = optarg; break;
+        default:
+            width = 0;
+        }
+    }
+
+    if (width == 0 || height == 0 || cols == 0 || rows == 0 || fps <= 0 || protocol == NULL) {
+        printf("Usage: %s -w WIDTH -h HEIGHT [-r FPS] [-i FILE] [-o OUTPUT] [-f HZ]\n"
+               "       [-p PROTOCOL] [-l LEDS | -m COLSxROWS [-z]] [-b BRIGHTNESS]\n"
+               "       [-R RECORDING]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t num_leds = cols * rows;
+    size_t frame_size = (size_t) width * height * 3;
+
+    // Precompute which source pixel every LED shows
+    uint32_t * map = (uint32_t *) malloc(num_leds * sizeof(uint32_t));
+    uint8_t * rgb = (uint8_t *) malloc(num_leds * 3);
+    if (map == NULL || rgb == NULL) {
+        free(rgb);
+        free(map);
+        return 1;
+    }
+    for (uint32_t row = 0; row < rows; row++) {
+        uint32_t y = (rows == 1) ? height / 2 : (uint32_t) (((uint64_t) 2 * row + 1) * height / (2 * rows));
+        for (uint32_t col = 0; col < cols; col++) {
+            uint32_t x = (uint32_t) (((uint64_t) 2 * col + 1) * width / (2 * cols));
+            uint32_t led_col = (zigzag && (row & 1)) ? cols - 1 - col : col;
+            map[row * cols + led_col] = (y * width + x) * 3;
+        }
+    }
+
+    led_strip_t * strip;
+    if (strncmp(output, "/dev/spidev", 11) == 0) {
+        strip = led_strip_create_linux_spi_protocol(output, frequency, num_leds, protocol);
+    } else {
+        strip = led_strip_create_linux_file_protocol(output, frequency, num_leds, protocol);
+    }
+    if (strip == NULL) {
+        free(rgb);
+        free(map);
+        return 1;
+    }
+
+    led_strip_recorder_t * recorder = NULL;
+    if (recording) {
+        recorder = led_strip_recorder_start(strip, recording, 0);
+        if (recorder == NULL) {
+            led_strip_destroy(strip);
+            free(rgb);
+            free(map);
+            return 1;
+        }
+    }
+
+    int fd = input ? open(input, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        printf("Can't open file %s.\n", input);
+        if (recorder) {
+            led_strip_recorder_stop(recorder, NULL);
+        }
+        led_strip_destroy(strip);
+        free(rgb);
+        free(map);
+        return 1;
+    }
+
+    // Regular files are mapped so frames are read in place, pipes are read
+    // with one large read per frame straight into the frame buffer.
+    struct stat info;
+    const uint8_t * mapped = NULL;
+    size_t mapped_frames = 0;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && (size_t) info.st_size >= frame_size) {
+        void * addr = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapped = (const uint8_t *) addr;
+            mapped_frames = (size_t) info.st_size / frame_size;
+            madvise(addr, (size_t) info.st_size, MADV_SEQUENTIAL);
+        }
+    }
+    uint8_t * frame_buffer = mapped ? NULL : (uint8_t *) malloc(frame_size);
+    int status = 0;
+    if (mapped == NULL && frame_buffer == NULL) {
+        printf("Can't allocate a frame of %zu bytes.\n", frame_size);
+        status = 1;
+    }
+
+    uint64_t period_ns = (uint64_t) (1000000000.0 / fps);
+    uint64_t start_ns = now_ns();
+    uint64_t shown = 0, dropped = 0;
+
+    for (uint64_t index = 0; status == 0; index++) {
+        const uint8_t * frame;
+
+        if (mapped) {
+            if (index >= mapped_frames) {
+                break;
+            }
+            frame = mapped + index * frame_size;
+        } else {
+            if (!read_frame(fd, frame_buffer, frame_size)) {
+                break;
+            }
+            frame = frame_buffer;
+        }
+
+        // Skip frames whose time has already passed
+        uint64_t due_ns = start_ns + index * period_ns;
+        if (now_ns() > due_ns + period_ns) {
+            dropped++;
+            continue;
+        }
+        sleep_until_ns(due_ns);
+
+        for (uint32_t i = 0; i < num_leds; i++) {
+            const uint8_t * pixel = frame + map[i];
+            rgb[3*i + 0] = pixel[0];
+            rgb[3*i + 1] = pixel[1];
+            rgb[3*i + 2] = pixel[2];
+        }
+        led_strip_set_pixels_rgb(strip, 0, num_leds, rgb, brightness);
+        if (led_strip_show(strip) != 0) {
+            printf("Can't show frame %llu.\n", (unsigned long long) index);
+            status = 1;
+            break;
+        }
+        shown++;
+    }
+
+    double seconds = (now_ns() - start_ns) / 1e9;
+    fprintf(stderr, "%llu frames shown, %llu dropped, %.1f fps\n",
+            (unsigned long long) shown, (unsigned long long) dropped,
+            seconds > 0 ? shown / seconds : 0.0);
+
+    if (mapped) {
+        munmap((void *) mapped, (size_t) info.st_size);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    free(frame_buffer);
+    free(rgb);
+    free(map);
+
+    led_strip_clear(strip);
+    led_strip_show(strip);
+
+    if (recorder) {
+        led_strip_recorder_stats_t stats;
+        led_strip_recorder_stop(recorder, &stats);
+        fprintf(stderr, "%llu frames recorded in %llu bytes, %llu dropped\n",
+                (unsigned long long) stats.frames, (unsigned long long) stats.bytes,
+                (unsigned long long) stats.dropped);
+    }
+    led_strip_destroy(strip);
+
+    return status;
+}
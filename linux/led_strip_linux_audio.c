@@ -0,0 +1,543 @@
+/*!
+@file led_strip_linux_audio.c
+
+@brief Implementation of the audio reactive pipeline.
+**/
+
+#include "led_strip_linux_audio.h"
+#include "led_strip_batch.h"
+#include "led_strip_struct.h"
+
+#include <stdio.h>
+#include <stdlib.h> // for calloc
+#include <string.h> // for memcmp
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#ifdef LED_STRIP_HAVE_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+#define AUDIO_MIN_FREQUENCY_HZ 40.0f
+#define AUDIO_MAX_FREQUENCY_HZ 16000.0f
+#define AUDIO_PEAK_DECAY 0.995f // Per block, so quiet passages still show
+#define AUDIO_PEAK_FLOOR 0.001f // Bands 30 dB below the loudest stay dark
+
+struct _led_strip_audio_t {
+    led_strip_t * led_strip;
+    led_strip_batch_t * batch;
+
+    FILE * wav;
+    void * pcm; // snd_pcm_t when capturing from ALSA
+    int realtime;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t block_size;
+    uint32_t num_bands;
+
+    // Buffers are allocated once so processing a block never allocates
+    int16_t * samples;   // block_size interleaved frames
+    float * window;      // Hann window, block_size
+    float * re;          // FFT of block_size/2 complex values
+    float * im;
+    uint32_t * bit_reverse;
+    float * cos_half;    // Twiddles of the block_size/2 FFT
+    float * sin_half;
+    float * cos_full;    // Twiddles to split into the block_size real FFT
+    float * sin_full;
+    uint32_t * band_bins; // num_bands + 1 bin edges
+    float * peaks;       // Recent peak energy per band
+
+    uint64_t start_ns;
+    uint64_t frames_read;
+    uint64_t wav_frames; // Frames in the data chunk of a WAV file
+    led_strip_audio_stats_t stats;
+};
+
+
+static uint64_t led_strip_audio_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static uint32_t led_strip_audio_read_u32(const uint8_t * bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+// Leave the file at the start of the samples
+static int led_strip_audio_read_wav_header(led_strip_audio_t * audio)
+{
+    uint8_t header[12];
+    uint8_t chunk[8];
+    uint8_t format[16];
+    int have_format = 0;
+
+    if (fread(header, 1, 12, audio->wav) != 12 ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+
+    while (fread(chunk, 1, 8, audio->wav) == 8) {
+        uint32_t size = led_strip_audio_read_u32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            if (fread(format, 1, 16, audio->wav) != 16) {
+                return -1;
+            }
+            // PCM, 16 bits per sample
+            if ((format[0] | (format[1] << 8)) != 1 || (format[14] | (format[15] << 8)) != 16) {
+                return -1;
+            }
+            audio->channels = format[2] | (format[3] << 8);
+            audio->sample_rate = led_strip_audio_read_u32(format + 4);
+            // Both divide the timing and the reads of every block
+            if (audio->channels == 0 || audio->sample_rate == 0) {
+                return -1;
+            }
+            have_format = 1;
+            size -= 16;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                return -1;
+            }
+            // Chunks after the samples, e.g. LIST, are not samples. Streamed
+            // files that don't know their length set it to the maximum.
+            audio->wav_frames = (size == 0xFFFFFFFF) ? UINT64_MAX
+                                                     : size / (audio->channels * 2);
+            return 0;
+        }
+
+        // Chunks are padded to an even size
+        if (fseek(audio->wav, size + (size & 1), SEEK_CUR) != 0) {
+            return -1;
+        }
+    }
+
+    return -1;
+}
+
+static led_strip_audio_t * led_strip_audio_create(led_strip_t * led_strip,
+                                                  uint32_t block_size,
+                                                  uint32_t num_bands)
+{
+    if (block_size < 4 || (block_size & (block_size - 1)) != 0 || num_bands == 0) {
+        return NULL;
+    }
+
+    led_strip_audio_t * audio = (led_strip_audio_t *) calloc(sizeof(led_strip_audio_t), 1);
+
+    if (!audio) {
+        return NULL;
+    }
+
+    uint32_t half = block_size / 2;
+
+    audio->led_strip = led_strip;
+    audio->block_size = block_size;
+    audio->num_bands = num_bands;
+    audio->batch = led_strip_batch_create(led_strip, 2 * num_bands);
+    audio->window = (float *) malloc(block_size * sizeof(float));
+    audio->re = (float *) malloc(half * sizeof(float));
+    audio->im = (float *) malloc(half * sizeof(float));
+    audio->bit_reverse = (uint32_t *) malloc(half * sizeof(uint32_t));
+    audio->cos_half = (float *) malloc(half / 2 * sizeof(float));
+    audio->sin_half = (float *) malloc(half / 2 * sizeof(float));
+    audio->cos_full = (float *) malloc(half * sizeof(float));
+    audio->sin_full = (float *) malloc(half * sizeof(float));
+    audio->band_bins = (uint32_t *) malloc((num_bands + 1) * sizeof(uint32_t));
+    audio->peaks = (float *) malloc(num_bands * sizeof(float));
+
+    if (!audio->batch || !audio->window || !audio->re || !audio->im ||
+        !audio->bit_reverse || !audio->cos_half || !audio->sin_half ||
+        !audio->cos_full || !audio->sin_full || !audio->band_bins || !audio->peaks) {
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < block_size; i++) {
+        audio->window[i] = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * i / block_size);
+    }
+
+    uint32_t bits = 0;
+    while ((1u << bits) < half) {
+        bits++;
+    }
+    for (uint32_t i = 0; i < half; i++) {
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        audio->bit_reverse[i] = reversed;
+    }
+
+    for (uint32_t k = 0; k < half / 2; k++) {
+        audio->cos_half[k] = cosf(2.0f * (float) M_PI * k / half);
+        audio->sin_half[k] = sinf(2.0f * (float) M_PI * k / half);
+    }
+    for (uint32_t k = 0; k < half; k++) {
+        audio->cos_full[k] = cosf(2.0f * (float) M_PI * k / block_size);
+        audio->sin_full[k] = sinf(2.0f * (float) M_PI * k / block_size);
+    }
+
+    for (uint32_t b = 0; b < num_bands; b++) {
+        audio->peaks[b] = 0.0f;
+    }
+
+    return audio;
+}
+
+// Spread the bands logarithmically, like hearing does
+static void led_strip_audio_compute_bands(led_strip_audio_t * audio)
+{
+    uint32_t half = audio->block_size / 2;
+    float max_frequency = audio->sample_rate / 2.0f;
+
+    if (max_frequency > AUDIO_MAX_FREQUENCY_HZ) {
+        max_frequency = AUDIO_MAX_FREQUENCY_HZ;
+    }
+
+    audio->band_bins[0] = 1; // Skip DC
+    for (uint32_t b = 1; b <= audio->num_bands; b++) {
+        float frequency = AUDIO_MIN_FREQUENCY_HZ *
+            powf(max_frequency / AUDIO_MIN_FREQUENCY_HZ, (float) b / audio->num_bands);
+        uint32_t bin = (uint32_t) (frequency * audio->block_size / audio->sample_rate + 0.5f);
+
+        // Every band gets at least one bin
+        if (bin <= audio->band_bins[b - 1]) {
+            bin = audio->band_bins[b - 1] + 1;
+        }
+        if (bin > half) {
+            bin = half;
+        }
+        audio->band_bins[b] = bin;
+    }
+
+    audio->stats.block_us = (uint32_t) ((uint64_t) audio->block_size * 1000000 / audio->sample_rate);
+}
+
+led_strip_audio_t * led_strip_audio_create_wav(led_strip_t * led_strip,
+                                               const char * path,
+                                               uint32_t block_size,
+                                               uint32_t num_bands,
+                                               int realtime)
+{
+    led_strip_audio_t * audio = led_strip_audio_create(led_strip, block_size, num_bands);
+
+    if (!audio) {
+        return NULL;
+    }
+
+    audio->wav = fopen(path, "rb");
+    if (!audio->wav) {
+        printf("Can't open file %s.\n", path);
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    if (led_strip_audio_read_wav_header(audio) != 0) {
+        printf("%s is not a 16 bit PCM WAV file.\n", path);
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    audio->samples = (int16_t *) malloc(block_size * audio->channels * sizeof(int16_t));
+    if (!audio->samples) {
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    audio->realtime = realtime;
+    audio->start_ns = led_strip_audio_now_ns();
+    led_strip_audio_compute_bands(audio);
+
+    return audio;
+}
+
+led_strip_audio_t * led_strip_audio_create_alsa(led_strip_t * led_strip,
+                                                const char * device,
+                                                uint32_t sample_rate,
+                                                uint32_t block_size,
+                                                uint32_t num_bands)
+{
+#ifdef LED_STRIP_HAVE_ALSA
+    if (sample_rate == 0) {
+        return NULL;
+    }
+
+    led_strip_audio_t * audio = led_strip_audio_create(led_strip, block_size, num_bands);
+
+    if (!audio) {
+        return NULL;
+    }
+
+    snd_pcm_t * pcm = NULL;
+    if (snd_pcm_open(&pcm, device, SND_PCM_STREAM_CAPTURE, 0) < 0) {
+        printf("Can't open capture device %s.\n", device);
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+    audio->pcm = pcm;
+    audio->channels = 1;
+    audio->sample_rate = sample_rate;
+
+    // Keep the ALSA buffer short, it adds directly to the latency
+    if (snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED,
+                           audio->channels, sample_rate, 1,
+                           (unsigned int) ((uint64_t) 2 * block_size * 1000000 / sample_rate)) < 0) {
+        printf("Can't configure capture device %s.\n", device);
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    audio->samples = (int16_t *) malloc(block_size * sizeof(int16_t));
+    if (!audio->samples) {
+        led_strip_audio_destroy(audio);
+        return NULL;
+    }
+
+    audio->start_ns = led_strip_audio_now_ns();
+    led_strip_audio_compute_bands(audio);
+
+    return audio;
+#else
+    (void) led_strip;
+    (void) sample_rate;
+    (void) block_size;
+    (void) num_bands;
+    printf("Can't open capture device %s. Built without ALSA.\n", device);
+    return NULL;
+#endif
+}
+
+// Read a block and return when its last sample was captured
+static int led_strip_audio_read_block(led_strip_audio_t * audio, uint64_t * captured_ns)
+{
+    uint32_t frames = audio->block_size;
+
+#ifdef LED_STRIP_HAVE_ALSA
+    if (audio->pcm) {
+        snd_pcm_t * pcm = (snd_pcm_t *) audio->pcm;
+        snd_pcm_sframes_t ret = snd_pcm_readi(pcm, audio->samples, frames);
+
+        if (ret == -EPIPE) {
+            // Overrun, we fell behind. Start again from live audio.
+            snd_pcm_prepare(pcm);
+            ret = snd_pcm_readi(pcm, audio->samples, frames);
+        }
+        if (ret < (snd_pcm_sframes_t) frames) {
+            return -1;
+        }
+
+        // Samples still waiting in the buffer were captured after ours
+        snd_pcm_sframes_t delay = 0;
+        snd_pcm_delay(pcm, &delay);
+        *captured_ns = led_strip_audio_now_ns() -
+                       (uint64_t) delay * 1000000000ULL / audio->sample_rate;
+        return 0;
+    }
+#endif
+
+    if (audio->wav_frames - audio->frames_read < frames ||
+        fread(audio->samples, audio->channels * sizeof(int16_t), frames, audio->wav) != frames) {
+        return 1;
+    }
+    audio->frames_read += frames;
+
+    if (audio->realtime) {
+        // Hold the block until the moment its last sample would have played
+        uint64_t due_ns = audio->start_ns +
+                          audio->frames_read * 1000000000ULL / audio->sample_rate;
+        struct timespec due;
+        due.tv_sec = (time_t) (due_ns / 1000000000ULL);
+        due.tv_nsec = (long) (due_ns % 1000000000ULL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR) {
+            // Interrupted by a signal, keep waiting
+        }
+        *captured_ns = due_ns;
+    } else {
+        *captured_ns = led_strip_audio_now_ns();
+    }
+
+    return 0;
+}
+
+// In place radix 2 FFT of block_size/2 complex values
+static void led_strip_audio_fft(led_strip_audio_t * audio)
+{
+    uint32_t n = audio->block_size / 2;
+    float * re = audio->re;
+    float * im = audio->im;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = audio->bit_reverse[i];
+        if (j > i) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (uint32_t len = 2; len <= n; len <<= 1) {
+        uint32_t half = len / 2;
+        uint32_t step = n / len;
+        for (uint32_t i = 0; i < n; i += len) {
+            for (uint32_t k = 0; k < half; k++) {
+                float wr = audio->cos_half[k * step];
+                float wi = -audio->sin_half[k * step];
+                uint32_t a = i + k;
+                uint32_t b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+static void led_strip_audio_analyze(led_strip_audio_t * audio)
+{
+    uint32_t half = audio->block_size / 2;
+    uint32_t channels = audio->channels;
+
+    // Pack the windowed mono signal as even samples in re and odd in im, so
+    // a real FFT of block_size takes one complex FFT of half the size.
+    for (uint32_t i = 0; i < half; i++) {
+        int32_t even = 0;
+        int32_t odd = 0;
+        for (uint32_t c = 0; c < channels; c++) {
+            even += audio->samples[(2 * i) * channels + c];
+            odd += audio->samples[(2 * i + 1) * channels + c];
+        }
+        audio->re[i] = audio->window[2 * i] * even / (32768.0f * channels);
+        audio->im[i] = audio->window[2 * i + 1] * odd / (32768.0f * channels);
+    }
+
+    led_strip_audio_fft(audio);
+
+    uint32_t num_leds = audio->led_strip->num_leds;
+    float loudest = 0.0f;
+
+    for (uint32_t band = 0; band < audio->num_bands; band++) {
+        if (audio->peaks[band] > loudest) {
+            loudest = audio->peaks[band];
+        }
+    }
+
+    for (uint32_t band = 0; band < audio->num_bands; band++) {
+        float energy = 0.0f;
+
+        for (uint32_t k = audio->band_bins[band]; k < audio->band_bins[band + 1]; k++) {
+            // Split the half size FFT into bin k of the real FFT
+            uint32_t mirror = (half - k) % half;
+            float sum_re = (audio->re[k] + audio->re[mirror]) * 0.5f;
+            float sum_im = (audio->im[k] - audio->im[mirror]) * 0.5f;
+            float diff_re = (audio->im[k] + audio->im[mirror]) * 0.5f;
+            float diff_im = (audio->re[mirror] - audio->re[k]) * 0.5f;
+            float wr = audio->cos_full[k];
+            float wi = -audio->sin_full[k];
+            float x_re = sum_re + diff_re * wr - diff_im * wi;
+            float x_im = sum_im + diff_re * wi + diff_im * wr;
+            energy += x_re * x_re + x_im * x_im;
+        }
+
+        // Level relative to the recent peak of this band
+        float peak = audio->peaks[band] * AUDIO_PEAK_DECAY;
+        if (energy > peak) {
+            peak = energy;
+        }
+        audio->peaks[band] = peak;
+        if (peak < loudest * AUDIO_PEAK_FLOOR) {
+            peak = loudest * AUDIO_PEAK_FLOOR;
+        }
+        if (peak < 1e-9f) {
+            peak = 1e-9f;
+        }
+        float level = sqrtf(energy / peak);
+
+        // Light a bar from the start of the band's segment
+        uint32_t first = band * num_leds / audio->num_bands;
+        uint32_t count = (band + 1) * num_leds / audio->num_bands - first;
+        uint32_t lit = (uint32_t) (level * count + 0.5f);
+        if (lit > count) {
+            lit = count;
+        }
+
+        // Bass is red, the middle green and treble blue
+        uint32_t position = (audio->num_bands > 1) ? band * 510 / (audio->num_bands - 1) : 0;
+        uint8_t r = (position < 255) ? (uint8_t) (255 - position) : 0;
+        uint8_t g = (position < 255) ? (uint8_t) position : (uint8_t) (510 - position);
+        uint8_t b = (position > 255) ? (uint8_t) (position - 255) : 0;
+
+        led_strip_batch_set_range_color_and_brightness(audio->batch, first, lit,
+                                                       r, g, b, PIXEL_MAX_BRIGHTNESS);
+        led_strip_batch_set_range_color_and_brightness(audio->batch, first + lit, count - lit,
+                                                       0, 0, 0, PIXEL_MAX_BRIGHTNESS);
+    }
+
+    led_strip_batch_apply(audio->batch);
+}
+
+int led_strip_audio_process(led_strip_audio_t * audio)
+{
+    uint64_t captured_ns;
+    int ret = led_strip_audio_read_block(audio, &captured_ns);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    led_strip_audio_analyze(audio);
+
+    if (led_strip_show(audio->led_strip) < 0) {
+        return -1;
+    }
+
+    uint64_t latency_us = (led_strip_audio_now_ns() - captured_ns) / 1000;
+    audio->stats.blocks++;
+    audio->stats.total_latency_us += latency_us;
+    if (latency_us > audio->stats.max_latency_us) {
+        audio->stats.max_latency_us = latency_us;
+    }
+
+    return 0;
+}
+
+void led_strip_audio_get_stats(led_strip_audio_t * audio,
+                               led_strip_audio_stats_t * stats)
+{
+    *stats = audio->stats;
+}
+
+void led_strip_audio_destroy(led_strip_audio_t * audio)
+{
+#ifdef LED_STRIP_HAVE_ALSA
+    if (audio->pcm) {
+        snd_pcm_close((snd_pcm_t *) audio->pcm);
+    }
+#endif
+    if (audio->wav) {
+        fclose(audio->wav);
+    }
+    if (audio->batch) {
+        led_strip_batch_destroy(audio->batch);
+    }
+
+    free(audio->samples);
+    free(audio->window);
+    free(audio->re);
+    free(audio->im);
+    free(audio->bit_reverse);
+    free(audio->cos_half);
+    free(audio->sin_half);
+    free(audio->cos_full);
+    free(audio->sin_full);
+    free(audio->band_bins);
+    free(audio->peaks);
+    free(audio);
+}
@@ -0,0 +1,84 @@
+/*!
+@file led_strip_linux_audio.h
+
+@brief Audio reactive pipeline for Linux. PCM is read block by block from a
+       WAV file or an ALSA capture device, such as a loopback. Each block is
+       split into frequency bands with a real FFT, each band lights one
+       segment of the strip, and the strip is shown once per block.
+**/
+
+#ifndef LED_STRIP_LINUX_AUDIO_H
+#define LED_STRIP_LINUX_AUDIO_H
+
+#include "led_strip.h"
+
+// Opaque data structure containing the audio source and analysis buffers.
+typedef struct _led_strip_audio_t led_strip_audio_t;
+
+typedef struct led_strip_audio_stats_t {
+    uint64_t blocks;           // Blocks shown
+    uint32_t block_us;         // Audio length of one block
+    uint64_t max_latency_us;   // Longest time from block captured to show done
+    uint64_t total_latency_us; // Sum of all times from block captured to show done
+} led_strip_audio_stats_t;
+
+/*
+@brief Create a pipeline that reads a 16 bit PCM WAV file.
+
+@param led_strip The led strip object. Its pixels are split evenly into
+                 one segment per band, lowest frequency first.
+@param path The WAV file, with at least one channel and a sample rate.
+@param block_size Samples per block and FFT size, a power of 2.
+@param num_bands The number of frequency bands.
+@param realtime Non-zero to release blocks at the rate they would play,
+                0 to process the file as fast as possible.
+@return A pointer to the allocated pipeline or NULL on error
+*/
+led_strip_audio_t * led_strip_audio_create_wav(led_strip_t * led_strip,
+                                               const char * path,
+                                               uint32_t block_size,
+                                               uint32_t num_bands,
+                                               int realtime);
+
+/*
+@brief Create a pipeline that captures from an ALSA device, for example
+       "hw:Loopback,1,0". Only available when built with ALSA.
+
+@param led_strip The led strip object.
+@param device The ALSA capture device.
+@param sample_rate Capture rate in Hz, above 0.
+@param block_size Samples per block and FFT size, a power of 2.
+@param num_bands The number of frequency bands.
+@return A pointer to the allocated pipeline or NULL on error
+*/
+led_strip_audio_t * led_strip_audio_create_alsa(led_strip_t * led_strip,
+                                                const char * device,
+                                                uint32_t sample_rate,
+                                                uint32_t block_size,
+                                                uint32_t num_bands);
+
+/*
+@brief Read one block, update the strip from its band energies and show it.
+
+@param audio The pipeline object.
+@return 0 on success, 1 at the end of the input and -1 on error
+*/
+int led_strip_audio_process(led_strip_audio_t * audio);
+
+/*
+@brief Read the latency counters of the pipeline.
+
+@param audio The pipeline object.
+@param stats Filled with a copy of the counters.
+*/
+void led_strip_audio_get_stats(led_strip_audio_t * audio,
+                               led_strip_audio_stats_t * stats);
+
+/*
+@brief Destroy the pipeline and free all resources. The strip is not destroyed.
+
+@param audio The pipeline object.
+*/
+void led_strip_audio_destroy(led_strip_audio_t * audio);
+
+#endif
@@ -0,0 +1,129 @@
+/*!
+@file led_strip_linux_file_backend.c
+
+@brief Implements the create, destroy, and show functions for the
+       Linux file backend.
+**/
+
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_no_backend.h"
+#include "led_strip_struct.h"
+
+#include <stdio.h>
+#include <stdlib.h> // for calloc
+#include <unistd.h> // for close
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/uio.h> // for writev
+
+typedef struct led_strip_backend_linux_file_t {
+    int fd;
+    uint32_t frequency;
+    struct iovec iov[3];
+} led_strip_backend_linux_file_t;
+
+
+int led_strip_show_linux_file(led_strip_t * led_strip);
+void led_strip_destroy_linux_file(led_strip_t * led_strip);
+
+led_strip_t * led_strip_create_linux_file(const char * path,
+                                          uint32_t frequency,
+                                          uint32_t num_leds)
+{
+    return led_strip_create_linux_file_protocol(path, frequency, num_leds,
+                                                &led_strip_protocol_apa102);
+}
+
+led_strip_t * led_strip_create_linux_file_protocol(const char * path,
+                                                   uint32_t frequency,
+                                                   uint32_t num_leds,
+                                                   const led_strip_protocol_t * protocol)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Can't open file %s.\n", path);
+        return NULL;
+    }
+
+    led_strip_t * led_strip = led_strip_create_no_backend_protocol(num_leds, protocol);
+
+    if (led_strip == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    // Set the backend functions
+    led_strip->show = &led_strip_show_linux_file;
+    led_strip->destroy = &led_strip_destroy_linux_file;
+
+    // Allocate and configure backend data
+    led_strip->backend_data = calloc(sizeof(led_strip_backend_linux_file_t), 1);
+
+    if (led_strip->backend_data == NULL) {
+        close(fd);
+        led_strip_destroy(led_strip);
+        return NULL;
+    }
+
+    led_strip_backend_linux_file_t * backend_data =
+        ((led_strip_backend_linux_file_t*)led_strip->backend_data);
+
+    backend_data->fd = fd;
+    backend_data->frequency = frequency;
+
+    // Header
+    backend_data->iov[0].iov_base = led_strip->header_data;
+    backend_data->iov[0].iov_len = led_strip->header_len;
+    // Color payload
+    backend_data->iov[1].iov_base = led_strip->tx_data;
+    backend_data->iov[1].iov_len = led_strip->tx_len;
+    // Footer
+    backend_data->iov[2].iov_base = led_strip->footer_data;
+    backend_data->iov[2].iov_len = led_strip->footer_len;
+
+    return led_strip;
+}
+
+int led_strip_show_linux_file(led_strip_t * led_strip)
+{
+    led_strip_backend_linux_file_t * backend_data =
+        ((led_strip_backend_linux_file_t*)led_strip->backend_data);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // The payload is sent from a scaled copy while the current is limited
+    backend_data->iov[1].iov_base = led_strip->tx_data;
+
+    ssize_t ret = writev(backend_data->fd, backend_data->iov, 3);
+    if (ret < 0) {
+        return -1;
+    }
+
+    if (backend_data->frequency) {
+        // Block until the frame would have been clocked out on a real bus
+        uint64_t bus_ns = ((uint64_t) ret * 8 * 1000000000ULL) / backend_data->frequency;
+        uint64_t end_ns = (uint64_t) start.tv_nsec + bus_ns;
+        struct timespec end;
+        end.tv_sec = start.tv_sec + (time_t) (end_ns / 1000000000ULL);
+        end.tv_nsec = (long) (end_ns % 1000000000ULL);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &end, NULL) == EINTR) {
+            // Interrupted by a signal, keep waiting
+        }
+    }
+
+    return 0;
+}
+
+void led_strip_destroy_linux_file(led_strip_t * led_strip)
+{
+    // Cast to the correct backend
+    led_strip_backend_linux_file_t * backend_data =
+        ((led_strip_backend_linux_file_t*)led_strip->backend_data);
+
+    if (backend_data) {
+        close(backend_data->fd);
+        free(backend_data);
+    }
+}
@@ -0,0 +1,43 @@
+/*!
+@file led_strip_linux_file_backend.h
+
+@brief The header file for the Linux file backend. This backend writes the
+       same byte stream the SPI backend would send to a file, which makes it
+       possible to run and measure the library without any hardware.
+**/
+
+#ifndef LED_STRIP_LINUX_FILE_BACKEND_H
+#define LED_STRIP_LINUX_FILE_BACKEND_H
+
+#include "led_strip.h"
+#include "led_strip_protocol.h"
+
+/*
+@brief Create a led strip that writes every shown frame to a file.
+
+@param path The file to write to, e.g. "/dev/null" or a capture file.
+@param frequency Simulated SPI frequency in Hz. Show blocks for as long as the
+                 frame would take on a real bus. 0 writes as fast as possible.
+@param num_leds The number of LEDs in the strip
+@return A pointer to the allocated led strip object or NULL on error
+*/
+led_strip_t * led_strip_create_linux_file(const char * path,
+                                          uint32_t frequency,
+                                          uint32_t num_leds);
+
+/*
+@brief Create a led strip that writes every shown frame of a given LED chip
+       to a file.
+
+@param path The file to write to, e.g. "/dev/null" or a capture file.
+@param frequency Simulated SPI frequency in Hz. 0 writes as fast as possible.
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_ws2801
+@return A pointer to the allocated led strip object or NULL on error
+*/
+led_strip_t * led_strip_create_linux_file_protocol(const char * path,
+                                                   uint32_t frequency,
+                                                   uint32_t num_leds,
+                                                   const led_strip_protocol_t * protocol);
+
+#endif
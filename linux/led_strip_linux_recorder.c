@@ -0,0 +1,503 @@
+/*!
+@file led_strip_linux_recorder.c
+
+@brief Implements recording shown frames and reading them back.
+**/
+
+#include "led_strip_linux_recorder.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+#include <stdio.h>
+#include <stdlib.h> // for calloc
+#include <string.h> // for memcpy
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#define RECORDER_MAGIC "LSRC"
+#define RECORDER_VERSION 2
+#define RECORDER_HEADER_LEN 10
+
+// A protocol is stored as its index here
+static const led_strip_protocol_t * const led_strip_recorder_protocols[] = {
+    &led_strip_protocol_apa102,
+    &led_strip_protocol_sk9822,
+    &led_strip_protocol_hd107s,
+    &led_strip_protocol_ws2801,
+};
+#define RECORDER_NUM_PROTOCOLS \
+    (sizeof(led_strip_recorder_protocols) / sizeof(led_strip_recorder_protocols[0]))
+#define RECORDER_UNKNOWN_PROTOCOL 0xFF
+
+typedef struct led_strip_recorder_frame_t {
+    uint64_t time_us;
+    uint32_t * pixels;
+} led_strip_recorder_frame_t;
+
+struct _led_strip_recorder_t {
+    led_strip_t * led_strip;
+    uint32_t num_leds;
+    FILE * file;
+
+    // Frames from show to the writer thread. Show fills the slot at head and
+    // the writer empties the one at tail, so neither copies under the mutex.
+    led_strip_recorder_frame_t * queue;
+    uint32_t queue_frames;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t queued;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t request; // Signaled when a frame was queued or on stop
+    int stop;
+
+    // Only used by the writer thread
+    uint32_t * previous;   // The last frame written
+    uint8_t * encoded;     // One frame in file format
+    uint64_t last_time_us; // Time of the last frame written
+    int written;           // A frame was written, so last_time_us is set
+
+    led_strip_recorder_stats_t stats;
+};
+
+struct _led_strip_recording_t {
+    FILE * file;
+    uint32_t num_leds;
+    const led_strip_protocol_t * protocol;
+    uint32_t * pixels;
+    uint64_t time_us;
+};
+
+
+static uint64_t led_strip_recorder_now_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000ULL + (uint64_t) now.tv_nsec / 1000;
+}
+
+static uint8_t * led_strip_recorder_put_varint(uint8_t * out, uint64_t value)
+{
+    while (value >= 0x80) {
+        *out++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t) value;
+    return out;
+}
+
+static uint8_t * led_strip_recorder_put_pixel(uint8_t * out, uint32_t pixel)
+{
+    out[0] = (uint8_t) pixel;
+    out[1] = (uint8_t) (pixel >> 8);
+    out[2] = (uint8_t) (pixel >> 16);
+    out[3] = (uint8_t) (pixel >> 24);
+    return out + 4;
+}
+
+// The largest encoding of a frame, every other LED changed
+static size_t led_strip_recorder_max_frame_size(uint32_t num_leds)
+{
+    return 10 + (size_t) (num_leds / 2 + 1) * (5 + 5 + 4) + 1;
+}
+
+// Encode the runs of LEDs that differ from the previous frame
+static size_t led_strip_recorder_encode(led_strip_recorder_t * recorder,
+                                        const led_strip_recorder_frame_t * frame,
+                                        uint32_t * changed)
+{
+    const uint32_t * pixels = frame->pixels;
+    uint32_t * previous = recorder->previous;
+    uint32_t num_leds = recorder->num_leds;
+    uint8_t * out = recorder->encoded;
+    uint32_t end = 0; // End of the previous run
+    uint32_t p = 0;
+
+    // Times are stored relative to the first frame written
+    if (!recorder->written) {
+        recorder->last_time_us = frame->time_us;
+        recorder->written = 1;
+    }
+
+    *changed = 0;
+    out = led_strip_recorder_put_varint(out, frame->time_us - recorder->last_time_us);
+    recorder->last_time_us = frame->time_us;
+
+    for (;;) {
+        while (p < num_leds && pixels[p] == previous[p]) {
+            p++;
+        }
+        if (p == num_leds) {
+            break;
+        }
+
+        uint32_t first = p;
+        while (p < num_leds && pixels[p] != previous[p]) {
+            previous[p] = pixels[p];
+            p++;
+        }
+
+        out = led_strip_recorder_put_varint(out, p - first);
+        out = led_strip_recorder_put_varint(out, first - end);
+        for (uint32_t i = first; i < p; i++) {
+            out = led_strip_recorder_put_pixel(out, pixels[i]);
+        }
+        *changed += p - first;
+        end = p;
+    }
+
+    out = led_strip_recorder_put_varint(out, 0);
+
+    return (size_t) (out - recorder->encoded);
+}
+
+static void * led_strip_recorder_thread(void * arg)
+{
+    led_strip_recorder_t * recorder = (led_strip_recorder_t *) arg;
+
+    pthread_mutex_lock(&recorder->mutex);
+    for (;;) {
+        while (recorder->queued == 0 && !recorder->stop) {
+            pthread_cond_wait(&recorder->request, &recorder->mutex);
+        }
+        // Write out everything that was queued before stopping
+        if (recorder->queued == 0) {
+            break;
+        }
+        led_strip_recorder_frame_t * frame = &recorder->queue[recorder->tail];
+        pthread_mutex_unlock(&recorder->mutex);
+
+        uint32_t changed;
+        size_t size = led_strip_recorder_encode(recorder, frame, &changed);
+        int error = 0;
+        if (fwrite(recorder->encoded, 1, size, recorder->file) != size) {
+            error = errno ? errno : EIO;
+        }
+
+        pthread_mutex_lock(&recorder->mutex);
+        recorder->tail = (recorder->tail + 1) % recorder->queue_frames;
+        recorder->queued--;
+        recorder->stats.frames++;
+        recorder->stats.changed += changed;
+        recorder->stats.bytes += size;
+        if (error) {
+            recorder->stats.last_error = error;
+        }
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+
+    return NULL;
+}
+
+static void led_strip_recorder_hook(led_strip_t * led_strip, const uint32_t * pixels, void * arg)
+{
+    led_strip_recorder_t * recorder = (led_strip_recorder_t *) arg;
+    uint64_t time_us = led_strip_recorder_now_us();
+    (void) pixels;
+
+    pthread_mutex_lock(&recorder->mutex);
+    int full = (recorder->queued == recorder->queue_frames);
+    if (full) {
+        // The next frame written is compared with the last one written, so
+        // dropping a frame loses its timing but never corrupts the file
+        recorder->stats.dropped++;
+    }
+    pthread_mutex_unlock(&recorder->mutex);
+
+    if (full) {
+        return;
+    }
+
+    // Only show moves head, so the slot can be filled without the mutex
+    // The colors as they are set, not as the power limit and calibration
+    // passed them on, so a replay through the same passes sends the same
+    led_strip_recorder_frame_t * frame = &recorder->queue[recorder->head];
+    memcpy(frame->pixels, led_strip->pixels, recorder->num_leds * sizeof(uint32_t));
+    frame->time_us = time_us;
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->head = (recorder->head + 1) % recorder->queue_frames;
+    recorder->queued++;
+    pthread_cond_signal(&recorder->request);
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
+static void led_strip_recorder_free(led_strip_recorder_t * recorder)
+{
+    if (recorder->queue) {
+        for (uint32_t i = 0; i < recorder->queue_frames; i++) {
+            free(recorder->queue[i].pixels);
+        }
+    }
+    free(recorder->queue);
+    free(recorder->previous);
+    free(recorder->encoded);
+    if (recorder->file) {
+        fclose(recorder->file);
+    }
+    free(recorder);
+}
+
+led_strip_recorder_t * led_strip_recorder_start(led_strip_t * led_strip,
+                                                const char * path,
+                                                uint32_t queue_frames)
+{
+    if (queue_frames == 0) {
+        queue_frames = LED_STRIP_RECORDER_DEFAULT_QUEUE;
+    }
+
+    led_strip_recorder_t * recorder = (led_strip_recorder_t *)
+        calloc(1, sizeof(led_strip_recorder_t));
+
+    if (!recorder) {
+        return NULL;
+    }
+
+    uint32_t num_leds = led_strip->num_leds;
+    recorder->led_strip = led_strip;
+    recorder->num_leds = num_leds;
+    recorder->queue_frames = queue_frames;
+    recorder->queue = (led_strip_recorder_frame_t *)
+        calloc(queue_frames, sizeof(led_strip_recorder_frame_t));
+    recorder->previous = (uint32_t *) calloc(num_leds, sizeof(uint32_t));
+    recorder->encoded = (uint8_t *) malloc(led_strip_recorder_max_frame_size(num_leds));
+
+    if (!recorder->queue || !recorder->previous || !recorder->encoded) {
+        led_strip_recorder_free(recorder);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < queue_frames; i++) {
+        recorder->queue[i].pixels = (uint32_t *) malloc(num_leds * sizeof(uint32_t));
+        if (!recorder->queue[i].pixels) {
+            led_strip_recorder_free(recorder);
+            return NULL;
+        }
+    }
+
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        printf("Can't open %s.\n", path);
+        led_strip_recorder_free(recorder);
+        return NULL;
+    }
+
+    // Views are sent by the strip they belong to
+    const led_strip_t * sender = led_strip;
+    while (sender->parent) {
+        sender = sender->parent;
+    }
+
+    uint8_t header[RECORDER_HEADER_LEN] = { 'L', 'S', 'R', 'C', RECORDER_VERSION };
+    led_strip_recorder_put_pixel(&header[5], num_leds);
+    header[9] = RECORDER_UNKNOWN_PROTOCOL;
+    for (uint32_t i = 0; i < RECORDER_NUM_PROTOCOLS; i++) {
+        if (sender->protocol == led_strip_recorder_protocols[i]) {
+            header[9] = (uint8_t) i;
+        }
+    }
+    if (fwrite(header, 1, sizeof(header), recorder->file) != sizeof(header)) {
+        led_strip_recorder_free(recorder);
+        return NULL;
+    }
+    recorder->stats.bytes = sizeof(header);
+
+    pthread_mutex_init(&recorder->mutex, NULL);
+    pthread_cond_init(&recorder->request, NULL);
+
+    if (pthread_create(&recorder->thread, NULL, &led_strip_recorder_thread, recorder) != 0) {
+        pthread_cond_destroy(&recorder->request);
+        pthread_mutex_destroy(&recorder->mutex);
+        led_strip_recorder_free(recorder);
+        return NULL;
+    }
+
+    led_strip_set_show_hook(led_strip, &led_strip_recorder_hook, recorder);
+
+    return recorder;
+}
+
+void led_strip_recorder_get_stats(led_strip_recorder_t * recorder,
+                                  led_strip_recorder_stats_t * stats)
+{
+    pthread_mutex_lock(&recorder->mutex);
+    *stats = recorder->stats;
+    pthread_mutex_unlock(&recorder->mutex);
+}
+
+int led_strip_recorder_stop(led_strip_recorder_t * recorder,
+                            led_strip_recorder_stats_t * stats)
+{
+    led_strip_set_show_hook(recorder->led_strip, NULL, NULL);
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->stop = 1;
+    pthread_cond_signal(&recorder->request);
+    pthread_mutex_unlock(&recorder->mutex);
+    pthread_join(recorder->thread, NULL);
+
+    int ret = (recorder->stats.last_error != 0) ? -1 : 0;
+    if (fclose(recorder->file) != 0) {
+        ret = -1;
+    }
+    recorder->file = NULL;
+
+    if (stats) {
+        *stats = recorder->stats;
+    }
+
+    pthread_cond_destroy(&recorder->request);
+    pthread_mutex_destroy(&recorder->mutex);
+    led_strip_recorder_free(recorder);
+
+    return ret;
+}
+
+// Returns -1 at the end of the file or if the varint is too long
+static int led_strip_recording_get_varint(FILE * file, uint64_t * value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(file);
+        if (c == EOF) {
+            return -1;
+        }
+        *value |= (uint64_t) (c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+led_strip_recording_t * led_strip_recording_open(const char * path)
+{
+    led_strip_recording_t * recording = (led_strip_recording_t *)
+        calloc(1, sizeof(led_strip_recording_t));
+
+    if (!recording) {
+        return NULL;
+    }
+
+    recording->file = fopen(path, "rb");
+    if (!recording->file) {
+        printf("Can't open %s.\n", path);
+        free(recording);
+        return NULL;
+    }
+
+    // Version 1 files have no protocol byte and were made on APA102 strips
+    uint8_t header[RECORDER_HEADER_LEN];
+    if (fread(header, 1, 9, recording->file) != 9 ||
+        memcmp(header, RECORDER_MAGIC, 4) != 0 || header[4] < 1 ||
+        header[4] > RECORDER_VERSION ||
+        (header[4] >= 2 && fread(&header[9], 1, 1, recording->file) != 1)) {
+        printf("%s is not a recording.\n", path);
+        led_strip_recording_close(recording);
+        return NULL;
+    }
+
+    if (header[4] == 1) {
+        recording->protocol = &led_strip_protocol_apa102;
+    } else if (header[9] < RECORDER_NUM_PROTOCOLS) {
+        recording->protocol = led_strip_recorder_protocols[header[9]];
+    }
+
+    recording->num_leds = (uint32_t) header[5] | (uint32_t) header[6] << 8 |
+                          (uint32_t) header[7] << 16 | (uint32_t) header[8] << 24;
+    recording->pixels = (uint32_t *) calloc(recording->num_leds, sizeof(uint32_t));
+
+    if (!recording->pixels && recording->num_leds) {
+        led_strip_recording_close(recording);
+        return NULL;
+    }
+
+    return recording;
+}
+
+uint32_t led_strip_recording_num_leds(led_strip_recording_t * recording)
+{
+    return recording->num_leds;
+}
+
+const led_strip_protocol_t * led_strip_recording_protocol(led_strip_recording_t * recording)
+{
+    return recording->protocol;
+}
+
+int led_strip_recording_next(led_strip_recording_t * recording,
+                             uint64_t * time_us,
+                             uint32_t * changed)
+{
+    uint64_t delta, length, skip;
+    uint32_t p = 0;
+    uint32_t count = 0;
+
+    // A clean end of file is only possible between frames
+    int c = getc(recording->file);
+    if (c == EOF) {
+        return 0;
+    }
+    ungetc(c, recording->file);
+
+    if (led_strip_recording_get_varint(recording->file, &delta) < 0) {
+        return -1;
+    }
+
+    for (;;) {
+        if (led_strip_recording_get_varint(recording->file, &length) < 0) {
+            return -1;
+        }
+        if (length == 0) {
+            break;
+        }
+        if (led_strip_recording_get_varint(recording->file, &skip) < 0 ||
+            skip > recording->num_leds - p || length > recording->num_leds - p - skip) {
+            return -1;
+        }
+
+        p += (uint32_t) skip;
+        for (uint32_t i = 0; i < length; i++) {
+            uint8_t bytes[4];
+            if (fread(bytes, 1, 4, recording->file) != 4) {
+                return -1;
+            }
+            recording->pixels[p++] = (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 |
+                                     (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+        }
+        count += (uint32_t) length;
+    }
+
+    recording->time_us += delta;
+    *time_us = recording->time_us;
+    if (changed) {
+        *changed = count;
+    }
+
+    return 1;
+}
+
+const uint32_t * led_strip_recording_pixels(led_strip_recording_t * recording)
+{
+    return recording->pixels;
+}
+
+void led_strip_recording_apply(led_strip_recording_t * recording,
+                               led_strip_t * led_strip)
+{
+    uint32_t num_leds = recording->num_leds < led_strip->num_leds ?
+                        recording->num_leds : led_strip->num_leds;
+
+    memcpy(led_strip->pixels, recording->pixels, num_leds * sizeof(uint32_t));
+    led_strip_power_invalidate(led_strip_power_of(led_strip));
+}
+
+void led_strip_recording_close(led_strip_recording_t * recording)
+{
+    if (recording->file) {
+        fclose(recording->file);
+    }
+    free(recording->pixels);
+    free(recording);
+}
@@ -0,0 +1,148 @@
+/*!
+@file led_strip_linux_recorder.h
+
+@brief Records every frame a strip shows to a file, and reads such a file back
+       for replay or analysis. Each frame is stored as the runs of LEDs that
+       changed since the previous frame plus the time since it, so a file
+       grows with the amount of change rather than with the strip length.
+       Show only copies the frame into a queue; a background thread compares
+       and writes it.
+
+       Frames are recorded as they are set, before the power limit and the
+       calibration of the strip change them on the way to the wire. Replay
+       them on a strip with the same limit and calibration to send the same
+       colors again.
+
+       File format, all integers as LEB128 varints unless noted:
+       "LSRC", a version byte, the number of LEDs as a little endian uint32,
+       the protocol of the strip as a byte (0 APA102, 1 SK9822, 2 HD107S,
+       3 WS2801, 255 any other), then per frame the microseconds since the
+       previous frame, 0 for the first, followed by
+       runs of (length, LEDs skipped since the previous run, length pixels
+       as little endian uint32) ending with a run of length 0.
+**/
+
+#ifndef LED_STRIP_LINUX_RECORDER_H
+#define LED_STRIP_LINUX_RECORDER_H
+
+#include "led_strip.h"
+#include "led_strip_protocol.h"
+
+// Frames show can queue before the writer falls behind and frames are dropped.
+#define LED_STRIP_RECORDER_DEFAULT_QUEUE 8
+
+// Opaque data structure containing the recorder.
+typedef struct _led_strip_recorder_t led_strip_recorder_t;
+
+// Opaque data structure containing a recording opened for reading.
+typedef struct _led_strip_recording_t led_strip_recording_t;
+
+typedef struct led_strip_recorder_stats_t {
+    uint64_t frames;      // Frames written to the file
+    uint64_t dropped;     // Frames not recorded because the queue was full
+    uint64_t changed;     // LEDs written over all frames
+    uint64_t bytes;       // Bytes written including the file header
+    int last_error;       // errno of the last failed write, 0 if none
+} led_strip_recorder_stats_t;
+
+/*
+@brief Start recording the frames shown on a strip. Uses the show hook of the
+       strip, so only one recorder can be attached at a time.
+
+@param led_strip The led strip object. Must outlive the recorder.
+@param path The file to record to. It is replaced if it exists.
+@param queue_frames Frames that can wait for the writer, 0 for
+                    LED_STRIP_RECORDER_DEFAULT_QUEUE.
+@return A pointer to the allocated recorder or NULL on error
+*/
+led_strip_recorder_t * led_strip_recorder_start(led_strip_t * led_strip,
+                                                const char * path,
+                                                uint32_t queue_frames);
+
+/*
+@brief Read the counters of a recorder.
+
+@param recorder The recorder object.
+@param stats Filled with a copy of the counters.
+*/
+void led_strip_recorder_get_stats(led_strip_recorder_t * recorder,
+                                  led_strip_recorder_stats_t * stats);
+
+/*
+@brief Write the queued frames, detach from the strip and close the file.
+
+@param recorder The recorder object.
+@param stats Filled with the final counters, may be NULL.
+@return -1 if any write failed
+*/
+int led_strip_recorder_stop(led_strip_recorder_t * recorder,
+                            led_strip_recorder_stats_t * stats);
+
+/*
+@brief Open a recording for reading. Before the first frame is read every LED
+       is 0.
+
+@param path The recorded file.
+@return A pointer to the allocated recording or NULL on error
+*/
+led_strip_recording_t * led_strip_recording_open(const char * path);
+
+/*
+@brief The number of LEDs of the recorded strip.
+
+@param recording The recording object.
+@return The number of LEDs
+*/
+uint32_t led_strip_recording_num_leds(led_strip_recording_t * recording);
+
+/*
+@brief The protocol the recorded strip sent with, so the recording can be
+       replayed on the same kind of strip. Strips that send through
+       led_strip_linux_rt are recorded as APA102, as that is the format the
+       wrapper holds its pixels in.
+
+@param recording The recording object.
+@return The protocol, or NULL if the strip used a protocol not listed in
+        led_strip_protocol.h
+*/
+const led_strip_protocol_t * led_strip_recording_protocol(led_strip_recording_t * recording);
+
+/*
+@brief Read the next frame.
+
+@param recording The recording object.
+@param time_us Set to the time of the frame since the first one, in microseconds.
+@param changed Set to the number of LEDs stored for the frame. May be NULL.
+@return 1 if a frame was read, 0 at the end of the file, -1 if it is corrupt
+*/
+int led_strip_recording_next(led_strip_recording_t * recording,
+                             uint64_t * time_us,
+                             uint32_t * changed);
+
+/*
+@brief The pixels of the last frame read, in the order they were sent and in
+       the internal pixel format.
+
+@param recording The recording object.
+@return led_strip_recording_num_leds words, valid until the next read
+*/
+const uint32_t * led_strip_recording_pixels(led_strip_recording_t * recording);
+
+/*
+@brief Copy the last frame read into a strip so it can be shown again. Copies
+       as many LEDs as both have. Does not write to the strip.
+
+@param recording The recording object.
+@param led_strip The led strip object.
+*/
+void led_strip_recording_apply(led_strip_recording_t * recording,
+                               led_strip_t * led_strip);
+
+/*
+@brief Close the file and free all resources.
+
+@param recording The recording object.
+*/
+void led_strip_recording_close(led_strip_recording_t * recording);
+
+#endif
@@ -0,0 +1,300 @@
+/*!
+@file led_strip_linux_render.c
+
+@brief Implements the work-stealing render pool.
+**/
+
+#include "led_strip_linux_render.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+#include <stdlib.h> // for posix_memalign
+#include <string.h> // for memset
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h> // for sysconf
+
+#define RENDER_CACHE_LINE 64
+
+// The tiles a thread still has to render. Next tile in the low half and end
+// in the high half, so both change together with a single compare and swap.
+// Each worker is on its own cache line so stealing doesn't slow the owner.
+typedef struct __attribute__((aligned(RENDER_CACHE_LINE))) led_strip_render_worker_t {
+    _Atomic uint64_t range;
+    struct _led_strip_render_t * render;
+    uint32_t index;
+    uint64_t tiles;
+    uint64_t steals;
+    pthread_t thread;
+} led_strip_render_worker_t;
+
+struct _led_strip_render_t {
+    led_strip_render_worker_t * workers;
+    uint32_t num_threads;
+    uint32_t started;       // Threads that were created
+    pthread_mutex_t mutex;
+    pthread_cond_t start;   // Signaled when a frame is ready to render
+    pthread_cond_t done;    // Signaled when the last thread finished a frame
+    uint64_t generation;    // Incremented for every frame
+    uint32_t running;       // Threads still rendering the current frame
+    int stop;
+
+    // The current frame
+    led_strip_t * led_strip;
+    led_strip_render_kernel_t kernel;
+    void * arg;
+    uint32_t misalignment;  // Pixels between the cache line and pixel 0
+
+    led_strip_render_stats_t stats;
+};
+
+
+static inline uint64_t led_strip_render_pack(uint32_t next, uint32_t end)
+{
+    return ((uint64_t) end << 32) | next;
+}
+
+static void led_strip_render_tile(led_strip_render_t * render, uint32_t tile)
+{
+    led_strip_t * led_strip = render->led_strip;
+    uint32_t num_leds = led_strip->num_leds;
+
+    // Tile boundaries follow the cache lines of the pixel buffer
+    uint32_t first = tile * LED_STRIP_RENDER_TILE_PIXELS;
+    uint32_t end = first + LED_STRIP_RENDER_TILE_PIXELS - render->misalignment;
+    first = (first > render->misalignment) ? first - render->misalignment : 0;
+    if (end > num_leds) {
+        end = num_leds;
+    }
+
+    // The kernel works in pixel order, which is mirrored on reversed strips
+    if (led_strip->reversed) {
+        render->kernel(led_strip, num_leds - end, end - first, render->arg);
+    } else {
+        render->kernel(led_strip, first, end - first, render->arg);
+    }
+}
+
+// Take half of the tiles left to another thread. Returns 0 if none were left.
+static int led_strip_render_steal(led_strip_render_worker_t * worker)
+{
+    led_strip_render_t * render = worker->render;
+
+    for (uint32_t i = 1; i < render->num_threads; i++) {
+        led_strip_render_worker_t * victim =
+            &render->workers[(worker->index + i) % render->num_threads];
+        uint64_t range = atomic_load(&victim->range);
+
+        for (;;) {
+            uint32_t next = (uint32_t) range;
+            uint32_t end = (uint32_t) (range >> 32);
+
+            if (next >= end) {
+                break;
+            }
+
+            uint32_t split = end - (end - next + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &range,
+                                             led_strip_render_pack(next, split))) {
+                atomic_store(&worker->range, led_strip_render_pack(split, end));
+                worker->steals++;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void led_strip_render_work(led_strip_render_worker_t * worker)
+{
+    do {
+        uint64_t range = atomic_load(&worker->range);
+
+        for (;;) {
+            uint32_t next = (uint32_t) range;
+            uint32_t end = (uint32_t) (range >> 32);
+
+            if (next >= end) {
+                break;
+            }
+
+            if (atomic_compare_exchange_weak(&worker->range, &range,
+                                             led_strip_render_pack(next + 1, end))) {
+                led_strip_render_tile(worker->render, next);
+                worker->tiles++;
+                range = led_strip_render_pack(next + 1, end);
+            }
+        }
+    } while (led_strip_render_steal(worker));
+}
+
+// Fold the counters of a worker into the pool and signal the end of the frame
+// if it was the last one. Called with the mutex held.
+static void led_strip_render_finish(led_strip_render_worker_t * worker)
+{
+    led_strip_render_t * render = worker->render;
+
+    render->stats.tiles += worker->tiles;
+    render->stats.steals += worker->steals;
+    worker->tiles = 0;
+    worker->steals = 0;
+
+    if (--render->running == 0) {
+        pthread_cond_signal(&render->done);
+    }
+}
+
+static void * led_strip_render_thread(void * arg)
+{
+    led_strip_render_worker_t * worker = (led_strip_render_worker_t *) arg;
+    led_strip_render_t * render = worker->render;
+    uint64_t generation = 0;
+
+    pthread_mutex_lock(&render->mutex);
+    for (;;) {
+        while (!render->stop && render->generation == generation) {
+            pthread_cond_wait(&render->start, &render->mutex);
+        }
+        if (render->stop) {
+            break;
+        }
+        generation = render->generation;
+        pthread_mutex_unlock(&render->mutex);
+
+        led_strip_render_work(worker);
+
+        pthread_mutex_lock(&render->mutex);
+        led_strip_render_finish(worker);
+    }
+    pthread_mutex_unlock(&render->mutex);
+
+    return NULL;
+}
+
+led_strip_render_t * led_strip_render_create(uint32_t num_threads)
+{
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = (cpus > 0) ? (uint32_t) cpus : 1;
+    }
+
+    led_strip_render_t * render = (led_strip_render_t *) calloc(1, sizeof(led_strip_render_t));
+
+    if (!render) {
+        return NULL;
+    }
+
+    void * workers;
+    if (posix_memalign(&workers, RENDER_CACHE_LINE,
+                       num_threads * sizeof(led_strip_render_worker_t)) != 0) {
+        free(render);
+        return NULL;
+    }
+    memset(workers, 0, num_threads * sizeof(led_strip_render_worker_t));
+
+    render->workers = (led_strip_render_worker_t *) workers;
+    render->num_threads = num_threads;
+    pthread_mutex_init(&render->mutex, NULL);
+    pthread_cond_init(&render->start, NULL);
+    pthread_cond_init(&render->done, NULL);
+
+    for (uint32_t i = 0; i < num_threads; i++) {
+        render->workers[i].render = render;
+        render->workers[i].index = i;
+        atomic_init(&render->workers[i].range, 0);
+    }
+
+    // The caller of led_strip_render_run is worker 0
+    for (uint32_t i = 1; i < num_threads; i++) {
+        if (pthread_create(&render->workers[i].thread, NULL,
+                           &led_strip_render_thread, &render->workers[i]) != 0) {
+            led_strip_render_destroy(render);
+            return NULL;
+        }
+        render->started = i;
+    }
+
+    return render;
+}
+
+void led_strip_render_run(led_strip_render_t * render,
+                          led_strip_t * led_strip,
+                          led_strip_render_kernel_t kernel,
+                          void * arg)
+{
+    uint32_t misalignment = (uint32_t) (((uintptr_t) led_strip->pixels % RENDER_CACHE_LINE)
+                                        / sizeof(uint32_t));
+    uint32_t num_tiles = (misalignment + led_strip->num_leds + LED_STRIP_RENDER_TILE_PIXELS - 1)
+                         / LED_STRIP_RENDER_TILE_PIXELS;
+
+    // The kernels write from several threads, so the current estimate can't
+    // follow each write. It is recomputed once afterwards instead. Views
+    // keep theirs on the strip they belong to.
+    led_strip_t * root = led_strip;
+    while (root->parent) {
+        root = root->parent;
+    }
+    struct _led_strip_power_t * power = root->power;
+    root->power = NULL;
+
+    pthread_mutex_lock(&render->mutex);
+
+    render->led_strip = led_strip;
+    render->kernel = kernel;
+    render->arg = arg;
+    render->misalignment = misalignment;
+
+    // Every thread starts with an equal share of the tiles
+    for (uint32_t i = 0; i < render->num_threads; i++) {
+        uint32_t first = (uint32_t) ((uint64_t) num_tiles * i / render->num_threads);
+        uint32_t end = (uint32_t) ((uint64_t) num_tiles * (i + 1) / render->num_threads);
+        atomic_store(&render->workers[i].range, led_strip_render_pack(first, end));
+    }
+
+    render->running = render->num_threads;
+    render->generation++;
+    pthread_cond_broadcast(&render->start);
+    pthread_mutex_unlock(&render->mutex);
+
+    led_strip_render_work(&render->workers[0]);
+
+    // Wait until every tile is written
+    pthread_mutex_lock(&render->mutex);
+    led_strip_render_finish(&render->workers[0]);
+    while (render->running > 0) {
+        pthread_cond_wait(&render->done, &render->mutex);
+    }
+    render->stats.frames++;
+    pthread_mutex_unlock(&render->mutex);
+
+    root->power = power;
+    led_strip_power_invalidate(power);
+}
+
+void led_strip_render_get_stats(led_strip_render_t * render,
+                                led_strip_render_stats_t * stats)
+{
+    pthread_mutex_lock(&render->mutex);
+    *stats = render->stats;
+    pthread_mutex_unlock(&render->mutex);
+}
+
+void led_strip_render_destroy(led_strip_render_t * render)
+{
+    pthread_mutex_lock(&render->mutex);
+    render->stop = 1;
+    pthread_cond_broadcast(&render->start);
+    pthread_mutex_unlock(&render->mutex);
+
+    for (uint32_t i = 1; i <= render->started; i++) {
+        pthread_join(render->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&render->done);
+    pthread_cond_destroy(&render->start);
+    pthread_mutex_destroy(&render->mutex);
+    free(render->workers);
+    free(render);
+}
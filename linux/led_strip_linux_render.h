@@ -0,0 +1,82 @@
+/*!
+@file led_strip_linux_render.h
+
+@brief Parallel rendering for very large strips on Linux. The pixels are split
+       into tiles of one cache line each, and a pool of threads runs a kernel
+       over the tiles. Every thread starts with an equal share of the tiles and
+       steals from the others when it runs out, so uneven kernels still keep
+       all cores busy. A frame is complete before render returns, so the strip
+       can be shown right after.
+**/
+
+#ifndef LED_STRIP_LINUX_RENDER_H
+#define LED_STRIP_LINUX_RENDER_H
+
+#include "led_strip.h"
+
+// Pixels per tile, one 64 byte cache line.
+#define LED_STRIP_RENDER_TILE_PIXELS 16
+
+// Opaque data structure containing the thread pool.
+typedef struct _led_strip_render_t led_strip_render_t;
+
+/*
+@brief Render a range of pixels. Called from several threads at once, each
+       with a different range, so it should only write pixels first to
+       first + count - 1 with the led_strip.h set functions.
+
+@param led_strip The led strip object being rendered.
+@param first The first pixel of the range.
+@param count The number of pixels in the range.
+@param arg The argument given to led_strip_render_run.
+*/
+typedef void (*led_strip_render_kernel_t)(led_strip_t * led_strip,
+                                          uint32_t first, uint32_t count,
+                                          void * arg);
+
+typedef struct led_strip_render_stats_t {
+    uint64_t frames; // Frames rendered
+    uint64_t tiles;  // Tiles rendered
+    uint64_t steals; // Times a thread took tiles from another one
+} led_strip_render_stats_t;
+
+/*
+@brief Create a thread pool for rendering.
+
+@param num_threads The number of threads including the caller of
+                   led_strip_render_run, 0 for one per online CPU.
+@return A pointer to the allocated pool or NULL on error
+*/
+led_strip_render_t * led_strip_render_create(uint32_t num_threads);
+
+/*
+@brief Run a kernel over every pixel of a strip and wait until all tiles are
+       done. The calling thread renders tiles too. Does not write to the strip.
+
+@param render The pool object.
+@param led_strip The led strip object.
+@param kernel The function that renders a range of pixels.
+@param arg Passed to every call of the kernel.
+*/
+void led_strip_render_run(led_strip_render_t * render,
+                          led_strip_t * led_strip,
+                          led_strip_render_kernel_t kernel,
+                          void * arg);
+
+/*
+@brief Read the counters of the pool.
+
+@param render The pool object.
+@param stats Filled with a copy of the counters.
+*/
+void led_strip_render_get_stats(led_strip_render_t * render,
+                                led_strip_render_stats_t * stats);
+
+/*
+@brief Stop the threads and free all resources.
+
+@param render The pool object.
+*/
+void led_strip_render_destroy(led_strip_render_t * render);
+
+#endif
@@ -0,0 +1,270 @@
+/*!
+@file led_strip_linux_rt.c
+
+@brief Implements the create, destroy, and show functions for real-time
+       transmission on Linux.
+**/
+
+#define _GNU_SOURCE // for CPU_SET and pthread_attr_setaffinity_np
+
+#include "led_strip_linux_rt.h"
+#include "led_strip_no_backend.h"
+#include "led_strip_struct.h"
+
+#include <stdio.h>
+#include <stdlib.h> // for calloc
+#include <string.h> // for memcpy
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+#include <sys/mman.h> // for mlockall
+
+typedef struct led_strip_backend_linux_rt_t {
+    led_strip_t * backend_strip; // Sends the frames from the transmit thread
+    pthread_t thread;
+    int started;            // The transmit thread is running
+    pthread_mutex_t mutex;
+    pthread_cond_t request; // Signaled when a frame is ready to send
+    pthread_cond_t done;    // Signaled when the thread finished sending
+    int busy;               // A frame is waiting or being sent
+    int stop;
+    int failed;             // The last frame failed and was not reported yet
+    uint64_t request_ns;    // When show handed over the current frame
+    led_strip_linux_rt_stats_t stats;
+} led_strip_backend_linux_rt_t;
+
+
+int led_strip_show_linux_rt(led_strip_t * led_strip);
+void led_strip_destroy_linux_rt(led_strip_t * led_strip);
+
+static uint64_t led_strip_linux_rt_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static void * led_strip_linux_rt_thread(void * arg)
+{
+    led_strip_backend_linux_rt_t * backend_data = (led_strip_backend_linux_rt_t *) arg;
+
+    pthread_mutex_lock(&backend_data->mutex);
+    for (;;) {
+        while (!backend_data->busy && !backend_data->stop) {
+            pthread_cond_wait(&backend_data->request, &backend_data->mutex);
+        }
+        if (backend_data->stop) {
+            break;
+        }
+        uint64_t request_ns = backend_data->request_ns;
+        pthread_mutex_unlock(&backend_data->mutex);
+
+        uint64_t start_ns = led_strip_linux_rt_now_ns();
+        int ret = led_strip_show(backend_data->backend_strip);
+        uint64_t end_ns = led_strip_linux_rt_now_ns();
+
+        pthread_mutex_lock(&backend_data->mutex);
+        led_strip_linux_rt_stats_t * stats = &backend_data->stats;
+        uint64_t wakeup_ns = start_ns - request_ns;
+        uint64_t transfer_ns = end_ns - start_ns;
+        uint64_t latency_ns = end_ns - request_ns;
+
+        stats->frames++;
+        stats->total_wakeup_ns += wakeup_ns;
+        stats->total_transfer_ns += transfer_ns;
+        stats->total_latency_ns += latency_ns;
+        if (wakeup_ns > stats->max_wakeup_ns) {
+            stats->max_wakeup_ns = wakeup_ns;
+        }
+        if (transfer_ns > stats->max_transfer_ns) {
+            stats->max_transfer_ns = transfer_ns;
+        }
+        if (latency_ns > stats->max_latency_ns) {
+            stats->max_latency_ns = latency_ns;
+        }
+        if (ret < 0) {
+            stats->errors++;
+            stats->last_error = ret;
+            backend_data->failed = 1;
+        }
+
+        backend_data->busy = 0;
+        pthread_cond_signal(&backend_data->done);
+    }
+    pthread_mutex_unlock(&backend_data->mutex);
+
+    return NULL;
+}
+
+static int led_strip_linux_rt_start_thread(led_strip_backend_linux_rt_t * backend_data,
+                                           const led_strip_linux_rt_config_t * config)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+
+    if (config->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config->cpu, &cpus);
+        int ret = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+        if (ret != 0) {
+            printf("Can't pin transmit thread to CPU %d: %s.\n", config->cpu, strerror(ret));
+            pthread_attr_destroy(&attr);
+            return ret;
+        }
+    }
+
+    if (config->priority > 0) {
+        struct sched_param param;
+        param.sched_priority = config->priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+
+    int ret = pthread_create(&backend_data->thread, &attr,
+                             &led_strip_linux_rt_thread, backend_data);
+
+    // Like locking memory, a priority that is not allowed fails create
+    // instead of silently running the thread at normal priority
+    if (ret == EPERM && config->priority > 0) {
+        printf("Can't set real-time priority. Try sudo or raise RLIMIT_RTPRIO.\n");
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return ret;
+}
+
+led_strip_t * led_strip_create_linux_rt(led_strip_t * backend_strip,
+                                        const led_strip_linux_rt_config_t * config)
+{
+    if (backend_strip == NULL) {
+        return NULL;
+    }
+
+    led_strip_backend_linux_rt_t * backend_data = (led_strip_backend_linux_rt_t *)
+        calloc(sizeof(led_strip_backend_linux_rt_t), 1);
+
+    if (backend_data == NULL) {
+        goto backend_allocation_error;
+    }
+
+    // The wrapping strip holds the pixels the user draws into, the backend
+    // strip holds the copy that is being sent and encodes it for its protocol.
+    led_strip_t * led_strip = led_strip_create_no_backend(backend_strip->num_leds);
+
+    if (led_strip == NULL) {
+        goto led_strip_allocation_error;
+    }
+
+    backend_data->backend_strip = backend_strip;
+
+    // Inherit priority so the transmit thread never waits on a preempted caller
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&backend_data->mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+    pthread_cond_init(&backend_data->request, NULL);
+    pthread_cond_init(&backend_data->done, NULL);
+
+    // Set the backend functions
+    led_strip->show = &led_strip_show_linux_rt;
+    led_strip->destroy = &led_strip_destroy_linux_rt;
+    led_strip->backend_data = backend_data;
+
+    // Lock every page of the process, now and later, so neither the buffers
+    // nor the stack of the transmit thread created below can fault. The
+    // buffers share pages with other allocations, so they are never unlocked.
+    if (config->lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        printf("Can't lock memory: %s. Try sudo or raise RLIMIT_MEMLOCK.\n", strerror(errno));
+        // Also destroys the backend strip
+        led_strip_destroy(led_strip);
+        return NULL;
+    }
+
+    if (led_strip_linux_rt_start_thread(backend_data, config) != 0) {
+        printf("Can't start transmit thread.\n");
+        // Also destroys the backend strip
+        led_strip_destroy(led_strip);
+        return NULL;
+    }
+    backend_data->started = 1;
+
+    return led_strip;
+
+led_strip_allocation_error:
+    free(backend_data);
+backend_allocation_error:
+    led_strip_destroy(backend_strip);
+    return NULL;
+}
+
+int led_strip_show_linux_rt(led_strip_t * led_strip)
+{
+    led_strip_backend_linux_rt_t * backend_data =
+        ((led_strip_backend_linux_rt_t*)led_strip->backend_data);
+
+    pthread_mutex_lock(&backend_data->mutex);
+    while (backend_data->busy) {
+        pthread_cond_wait(&backend_data->done, &backend_data->mutex);
+    }
+
+    // Send what show prepared, which is a scaled copy while the current is limited
+    memcpy(backend_data->backend_strip->pixels, led_strip->tx_data,
+           led_strip->num_leds * sizeof(uint32_t));
+
+    int failed = backend_data->failed;
+    backend_data->failed = 0;
+    backend_data->busy = 1;
+    backend_data->request_ns = led_strip_linux_rt_now_ns();
+    pthread_cond_signal(&backend_data->request);
+    pthread_mutex_unlock(&backend_data->mutex);
+
+    // Sending is asynchronous, so report a failure of the previous frame
+    return failed ? -1 : 0;
+}
+
+void led_strip_linux_rt_get_stats(led_strip_t * led_strip,
+                                  led_strip_linux_rt_stats_t * stats)
+{
+    assert(led_strip->show == &led_strip_show_linux_rt && "Not a real-time strip");
+
+    led_strip_backend_linux_rt_t * backend_data =
+        ((led_strip_backend_linux_rt_t*)led_strip->backend_data);
+
+    pthread_mutex_lock(&backend_data->mutex);
+    *stats = backend_data->stats;
+    pthread_mutex_unlock(&backend_data->mutex);
+}
+
+void led_strip_destroy_linux_rt(led_strip_t * led_strip)
+{
+    assert(led_strip->backend_data && "No backend created in create function");
+
+    // Cast to the correct backend
+    led_strip_backend_linux_rt_t * backend_data =
+        ((led_strip_backend_linux_rt_t*)led_strip->backend_data);
+
+    if (backend_data->started) {
+        // Let the last frame finish before stopping the thread
+        pthread_mutex_lock(&backend_data->mutex);
+        while (backend_data->busy) {
+            pthread_cond_wait(&backend_data->done, &backend_data->mutex);
+        }
+        backend_data->stop = 1;
+        pthread_cond_signal(&backend_data->request);
+        pthread_mutex_unlock(&backend_data->mutex);
+        pthread_join(backend_data->thread, NULL);
+    }
+
+    pthread_cond_destroy(&backend_data->done);
+    pthread_cond_destroy(&backend_data->request);
+    pthread_mutex_destroy(&backend_data->mutex);
+
+    led_strip_destroy(backend_data->backend_strip);
+    free(backend_data);
+}
@@ -0,0 +1,67 @@
+/*!
+@file led_strip_linux_rt.h
+
+@brief Real-time transmission for Linux backends. The wrapped strip is shown
+       from a dedicated thread that can run with SCHED_FIFO priority on a fixed
+       CPU, and its buffers can be locked in memory to avoid page faults.
+       Errors are counted instead of printed so the show path stays short.
+**/
+
+#ifndef LED_STRIP_LINUX_RT_H
+#define LED_STRIP_LINUX_RT_H
+
+#include "led_strip.h"
+
+typedef struct led_strip_linux_rt_config_t {
+    int lock_memory; // Non-zero to lock all memory of the process, see below
+    int priority;    // SCHED_FIFO priority of the transmit thread, 0 for none
+    int cpu;         // CPU to pin the transmit thread to, -1 for any
+} led_strip_linux_rt_config_t;
+
+typedef struct led_strip_linux_rt_stats_t {
+    uint64_t frames;          // Frames handed to the backend
+    uint64_t errors;          // Frames the backend failed to send
+    int last_error;           // Return value of the last failed show
+    uint64_t max_wakeup_ns;   // Longest delay from show to start of transfer
+    uint64_t total_wakeup_ns; // Sum of all delays from show to start of transfer
+    uint64_t max_transfer_ns; // Longest time the backend took to send a frame
+    uint64_t total_transfer_ns; // Sum of all backend send times
+    uint64_t max_latency_ns;  // Longest delay from show to end of transfer
+    uint64_t total_latency_ns; // Sum of all delays from show to end of transfer
+} led_strip_linux_rt_stats_t;
+
+/*
+@brief Wrap a led strip so it is shown from a real-time thread. Show copies the
+       pixels into a second buffer and returns while the thread sends them,
+       waiting only if the previous frame is still being sent.
+
+       With lock_memory, every page of the process is locked with
+       mlockall(MCL_CURRENT | MCL_FUTURE), including the stack of the
+       transmit thread and anything mapped later. Creating fails if that is
+       not allowed, e.g. by RLIMIT_MEMLOCK. The memory stays locked after
+       destroy, as other code of the process may rely on it.
+
+       Likewise creating fails if the priority is not allowed, e.g. without
+       root or RLIMIT_RTPRIO, or the CPU does not exist. Set priority to 0 or
+       cpu to -1 to run the thread without them.
+
+@param backend_strip The strip that sends the frames. It is owned by the
+                     returned strip and destroyed with it.
+@param config The real-time configuration.
+@return A pointer to the allocated led strip object or NULL on error, in
+        which case backend_strip is destroyed
+*/
+led_strip_t * led_strip_create_linux_rt(led_strip_t * backend_strip,
+                                        const led_strip_linux_rt_config_t * config);
+
+/*
+@brief Read the transmission counters of a strip created with
+       led_strip_create_linux_rt.
+
+@param led_strip The led strip object.
+@param stats Filled with a copy of the counters.
+*/
+void led_strip_linux_rt_get_stats(led_strip_t * led_strip,
+                                  led_strip_linux_rt_stats_t * stats);
+
+#endif
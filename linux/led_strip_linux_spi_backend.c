@@ -15,101 +15,201 @@
 #include <unistd.h> // for close
 #include <fcntl.h>
 #include <assert.h>
-#include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <linux/spi/spidev.h>
 
 typedef struct led_strip_backend_linux_spi_t {
     int fd; // SPI file descriptor
     struct spi_ioc_transfer xfer[3];
+    uint32_t num_xfers; // Header and footer are skipped if they are empty
+    uint32_t payload;   // The transfer of the color payload
 } led_strip_backend_linux_spi_t;
 
+#define LED_STRIP_LINUX_SPI_BITS 8
+
 
 int led_strip_show_linux_spi(led_strip_t * led_strip);
 void led_strip_destroy_linux_spi(led_strip_t * led_strip);
+void led_strip_destroy_linux_spi_arena(led_strip_t * led_strip);
+
+static void led_strip_linux_spi_add_xfer(led_strip_backend_linux_spi_t * backend_data,
+                                         const uint8_t * data, uint32_t len,
+                                         uint32_t frequency, uint8_t bits)
+{
+    if (len == 0) {
+        return;
+    }
+
+    struct spi_ioc_transfer * xfer = &backend_data->xfer[backend_data->num_xfers++];
+    xfer->tx_buf = (unsigned long) data;
+    xfer->len = len;
+    xfer->speed_hz = frequency;
+    xfer->bits_per_word = bits;
+}
 
 led_strip_t * led_strip_create_linux_spi(const char * device,
                                          uint32_t frequency,
                                          uint32_t num_leds)
 {
-    // For this backend we want to make sure the SPI is working before
-    // allocating anything.
+    return led_strip_create_linux_spi_protocol(device, frequency, num_leds,
+                                               &led_strip_protocol_apa102);
+}
+
+// Open and configure the SPI device. Returns the file descriptor or -1.
+static int led_strip_linux_spi_open(const char * device, uint32_t frequency)
+{
     int ret = 0;
 
     int fd = open(device, O_RDWR);
     if (fd < 0) {
         printf("Can't open device %s. Try sudo.\n", device);
-        return NULL;
+        return -1;
     }
 
     uint8_t mode = 0;
     ret = ioctl(fd, SPI_IOC_WR_MODE, &mode);
     if (ret == -1) {
         printf("Can't set spi mode.\n");
-        return NULL;
+        close(fd);
+        return -1;
     }
 
-    uint8_t bits = 8;
+    uint8_t bits = LED_STRIP_LINUX_SPI_BITS;
     ret = ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits);
     if (ret == -1) {
         printf("Can't set bits per word.\n");
-        return NULL;
+        close(fd);
+        return -1;
     }
 
     ret = ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &frequency);
     if (ret == -1) {
         printf("Can't set max speed HZ.\n");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Attach zeroed backend data to a strip and build its transfers
+static void led_strip_linux_spi_attach(led_strip_t * led_strip,
+                                       led_strip_backend_linux_spi_t * backend_data,
+                                       int fd, uint32_t frequency)
+{
+    led_strip->show = &led_strip_show_linux_spi;
+    led_strip->backend_data = backend_data;
+
+    backend_data->fd = fd;
+
+    // Header
+    led_strip_linux_spi_add_xfer(backend_data, led_strip->header_data,
+                                 led_strip->header_len, frequency, LED_STRIP_LINUX_SPI_BITS);
+    // Color payload
+    backend_data->payload = backend_data->num_xfers;
+    led_strip_linux_spi_add_xfer(backend_data, led_strip->tx_data,
+                                 led_strip->tx_len, frequency, LED_STRIP_LINUX_SPI_BITS);
+    // Footer
+    led_strip_linux_spi_add_xfer(backend_data, led_strip->footer_data,
+                                 led_strip->footer_len, frequency, LED_STRIP_LINUX_SPI_BITS);
+}
+
+led_strip_t * led_strip_create_linux_spi_protocol(const char * device,
+                                                  uint32_t frequency,
+                                                  uint32_t num_leds,
+                                                  const led_strip_protocol_t * protocol)
+{
+    // For this backend we want to make sure the SPI is working before
+    // allocating anything.
+    int fd = led_strip_linux_spi_open(device, frequency);
+    if (fd < 0) {
         return NULL;
     }
 
+    // Allocate backend data
+    led_strip_backend_linux_spi_t * backend_data = (led_strip_backend_linux_spi_t *)
+        calloc(sizeof(led_strip_backend_linux_spi_t), 1);
+
+    if (backend_data == NULL) {
+        goto backend_allocation_error;
+    }
+
     // Now we can create the strip without a backend.
-    led_strip_t * led_strip = led_strip_create_no_backend(num_leds);
+    led_strip_t * led_strip = led_strip_create_no_backend_protocol(num_leds, protocol);
 
     if (led_strip == NULL) {
-        return NULL;
+        goto led_strip_allocation_error;
     }
 
-    // Set the backend functions
-    led_strip->show = &led_strip_show_linux_spi;
+    led_strip_linux_spi_attach(led_strip, backend_data, fd, frequency);
     led_strip->destroy = &led_strip_destroy_linux_spi;
 
-    // Allocate and configure backend data
-    led_strip->backend_data = calloc(sizeof(led_strip_backend_linux_spi_t), 1);
+    return led_strip;
 
-    // This will make it easier to read the following code
-    led_strip_backend_linux_spi_t * backend_data =
-        ((led_strip_backend_linux_spi_t*)led_strip->backend_data);
+led_strip_allocation_error:
+    free(backend_data);
+backend_allocation_error:
+    close(fd);
+    return NULL;
+}
 
-    backend_data->fd = fd;
+size_t led_strip_linux_spi_required_size(uint32_t num_leds,
+                                         const led_strip_protocol_t * protocol)
+{
+    return led_strip_required_size(num_leds, protocol) +
+           LED_STRIP_ARENA_SIZE(sizeof(led_strip_backend_linux_spi_t));
+}
 
-    // Header
-    backend_data->xfer[0].tx_buf = (unsigned long) led_strip->header_data;
-    backend_data->xfer[0].len = HEADER_LENGTH_IN_BYTES;
-    backend_data->xfer[0].speed_hz = frequency;
-    backend_data->xfer[0].bits_per_word = bits;
-    // Color payload
-    backend_data->xfer[1].tx_buf = (unsigned long) led_strip->pixels;
-    backend_data->xfer[1].len = led_strip->num_leds * sizeof(led_strip->num_leds);
-    backend_data->xfer[1].speed_hz = frequency;
-    backend_data->xfer[1].bits_per_word = bits;
-    // Footer
-    backend_data->xfer[2].tx_buf = (unsigned long) led_strip->footer_data;
-    backend_data->xfer[2].len = led_strip->footer_len;
-    backend_data->xfer[2].speed_hz = frequency;
-    backend_data->xfer[2].bits_per_word = bits;
+led_strip_t * led_strip_create_linux_spi_arena(led_strip_arena_t * arena,
+                                               const char * device,
+                                               uint32_t frequency,
+                                               uint32_t num_leds,
+                                               const led_strip_protocol_t * protocol)
+{
+    if (led_strip_linux_spi_required_size(num_leds, protocol) > arena->size - arena->used) {
+        return NULL;
+    }
+
+    int fd = led_strip_linux_spi_open(device, frequency);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    // Both fit, so neither can fail
+    led_strip_t * led_strip = led_strip_create_no_backend_arena(arena, num_leds, protocol);
+    led_strip_backend_linux_spi_t * backend_data = (led_strip_backend_linux_spi_t *)
+        led_strip_arena_alloc(arena, sizeof(led_strip_backend_linux_spi_t));
+    memset(backend_data, 0, sizeof(led_strip_backend_linux_spi_t));
+
+    led_strip_linux_spi_attach(led_strip, backend_data, fd, frequency);
+    led_strip->destroy = &led_strip_destroy_linux_spi_arena;
 
     return led_strip;
 }
 
+led_strip_t * led_strip_create_linux_spi_rt(const char * device,
+                                            uint32_t frequency,
+                                            uint32_t num_leds,
+                                            const led_strip_linux_rt_config_t * config)
+{
+    return led_strip_create_linux_rt(led_strip_create_linux_spi(device, frequency, num_leds),
+                                     config);
+}
+
 int led_strip_show_linux_spi(led_strip_t * led_strip)
 {
     led_strip_backend_linux_spi_t * backend_data =
         ((led_strip_backend_linux_spi_t*)led_strip->backend_data);
 
-    int ret = ioctl(backend_data->fd, SPI_IOC_MESSAGE(3), backend_data->xfer);
+    // The payload is sent from a scaled copy while the current is limited
+    backend_data->xfer[backend_data->payload].tx_buf = (unsigned long) led_strip->tx_data;
+
+    // No printing here, this runs for every frame. Failures are returned
+    // and counted by the real-time wrapper.
+    int ret = ioctl(backend_data->fd, SPI_IOC_MESSAGE(backend_data->num_xfers),
+                    backend_data->xfer);
     if (ret < 1) {
-        printf("Can't send spi message.\n");
-        return ret;
+        return -1;
     }
     return 0;
 }
@@ -129,3 +229,16 @@ void led_strip_destroy_linux_spi(led_strip_t * led_strip)
 
     free(backend_data);
 }
+
+void led_strip_destroy_linux_spi_arena(led_strip_t * led_strip)
+{
+    assert(led_strip->backend_data && "No backend created in create function");
+
+    led_strip_backend_linux_spi_t * backend_data =
+        ((led_strip_backend_linux_spi_t*)led_strip->backend_data);
+
+    // The backend data is in the arena, only the SPI port is closed
+    if (backend_data->fd) {
+        close(backend_data->fd);
+    }
+}
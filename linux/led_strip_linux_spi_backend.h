@@ -8,9 +8,71 @@
 #define LED_STRIP_LINUX_SPI_BACKEND_H
 
 #include "led_strip.h"
+#include "led_strip_linux_rt.h"
+#include "led_strip_protocol.h"
+#include "led_strip_arena.h"
 
 led_strip_t * led_strip_create_linux_spi(const char * device,
                                          uint32_t frequency,
                                          uint32_t num_leds);
 
+/*
+@brief Create a Linux SPI strip for a given LED chip.
+
+@param device The SPI device, e.g. "/dev/spidev1.0"
+@param frequency SPI frequency in Hz, up to protocol->max_frequency
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_hd107s
+@return A pointer to the allocated led strip object or NULL on error
+*/
+led_strip_t * led_strip_create_linux_spi_protocol(const char * device,
+                                                  uint32_t frequency,
+                                                  uint32_t num_leds,
+                                                  const led_strip_protocol_t * protocol);
+
+/*
+@brief The number of bytes a Linux SPI strip takes from an arena, including
+       its backend data.
+
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_apa102
+@return The size in bytes
+*/
+size_t led_strip_linux_spi_required_size(uint32_t num_leds,
+                                         const led_strip_protocol_t * protocol);
+
+/*
+@brief Create a Linux SPI strip in an arena without touching the heap.
+       led_strip_destroy closes the device, and the memory is released with
+       led_strip_arena_reset.
+
+@param arena The arena object.
+@param device The SPI device, e.g. "/dev/spidev1.0"
+@param frequency SPI frequency in Hz, up to protocol->max_frequency
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_apa102
+@return A pointer to the led strip object or NULL if the arena is full or
+        the device can't be opened
+*/
+led_strip_t * led_strip_create_linux_spi_arena(led_strip_arena_t * arena,
+                                               const char * device,
+                                               uint32_t frequency,
+                                               uint32_t num_leds,
+                                               const led_strip_protocol_t * protocol);
+
+/*
+@brief Create a Linux SPI strip that is shown from a real-time thread.
+       See led_strip_linux_rt.h for the configuration and counters.
+
+@param device The SPI device, e.g. "/dev/spidev1.0"
+@param frequency SPI frequency in Hz
+@param num_leds The number of LEDs in the strip
+@param config The real-time configuration.
+@return A pointer to the allocated led strip object or NULL on error
+*/
+led_strip_t * led_strip_create_linux_spi_rt(const char * device,
+                                            uint32_t frequency,
+                                            uint32_t num_leds,
+                                            const led_strip_linux_rt_config_t * config);
+
 #endif
@@ -12,9 +12,22 @@ inline LedStrip::LedStrip(uint32_t num_leds)
     this->led_strip = led_strip_create_no_backend(num_leds);
 }
 
+inline LedStrip::LedStrip(uint32_t num_leds, const led_strip_protocol_t * protocol)
+{
+    this->led_strip = led_strip_create_no_backend_protocol(num_leds, protocol);
+}
+
+inline LedStrip::LedStrip(led_strip_t * led_strip)
+{
+    this->led_strip = led_strip;
+}
+
 inline LedStrip::~LedStrip()
 {
-    led_strip_destroy(this->led_strip);
+    // NULL if create failed, e.g. for a view out of the range of its parent
+    if (this->led_strip) {
+        led_strip_destroy(this->led_strip);
+    }
 }
 
 inline int LedStrip::show()
@@ -51,6 +64,12 @@ inline void LedStrip::getPixelColorAndBrightness(uint32_t p,
     led_strip_get_pixel_color_and_brightness(this->led_strip, p, r, g, b, brightness);
 }
 
+inline void LedStrip::setPixelsRgb(uint32_t first, uint32_t count, const uint8_t * rgb,
+                                   uint8_t brightness)
+{
+    led_strip_set_pixels_rgb(this->led_strip, first, count, rgb, brightness);
+}
+
 inline void LedStrip::setColorAndBrightness(uint8_t r, uint8_t g, uint8_t b,
                                                uint8_t brightness)
 {
@@ -89,3 +108,157 @@ inline void LedStrip::rotateRight()
     led_strip_rotate_right(this->led_strip);
 }
 
+inline led_strip_snapshot_t * LedStrip::saveSnapshot()
+{
+    return led_strip_snapshot_save(this->led_strip);
+}
+
+inline int LedStrip::restoreSnapshot(const led_strip_snapshot_t * snapshot)
+{
+    return led_strip_snapshot_restore(this->led_strip, snapshot);
+}
+
+inline void LedStrip::destroySnapshot(led_strip_snapshot_t * snapshot)
+{
+    led_strip_snapshot_destroy(snapshot);
+}
+
+inline void LedStrip::scaleRange(uint32_t first, uint32_t count, uint8_t scale)
+{
+    led_strip_scale_range(this->led_strip, first, count, scale);
+}
+
+inline void LedStrip::blendRange(uint32_t first, uint32_t count,
+                                 uint8_t r, uint8_t g, uint8_t b, uint8_t amount)
+{
+    led_strip_blend_range(this->led_strip, first, count, r, g, b, amount);
+}
+
+inline uint8_t LedStrip::scale8(uint8_t value, uint8_t scale)
+{
+    return led_strip_scale8(value, scale);
+}
+
+inline uint8_t LedStrip::blend8(uint8_t a, uint8_t b, uint8_t amount)
+{
+    return led_strip_blend8(a, b, amount);
+}
+
+inline uint8_t LedStrip::sin8(uint8_t theta)
+{
+    return led_strip_sin8(theta);
+}
+
+inline uint8_t LedStrip::cos8(uint8_t theta)
+{
+    return led_strip_cos8(theta);
+}
+
+inline uint8_t LedStrip::ease8(uint8_t t)
+{
+    return led_strip_ease8(t);
+}
+
+inline uint8_t LedStrip::noise8(uint16_t x)
+{
+    return led_strip_noise8(x);
+}
+
+inline LedStripView::LedStripView(LedStrip & parent, uint32_t offset, uint32_t length,
+                                  bool reversed)
+    : LedStrip(led_strip_view_create(parent.led_strip, offset, length, reversed))
+{
+}
+
+inline int LedStrip::enablePowerLimit(uint32_t budget_ma,
+                                      const led_strip_power_model_t * model)
+{
+    return led_strip_power_enable(this->led_strip, model, budget_ma);
+}
+
+inline void LedStrip::disablePowerLimit()
+{
+    led_strip_power_disable(this->led_strip);
+}
+
+inline void LedStrip::setPowerBudget(uint32_t budget_ma)
+{
+    led_strip_power_set_budget(this->led_strip, budget_ma);
+}
+
+inline uint32_t LedStrip::getPowerEstimate()
+{
+    return led_strip_power_estimate_ma(this->led_strip);
+}
+
+inline uint16_t LedStrip::getPowerScale()
+{
+    return led_strip_power_get_scale(this->led_strip);
+}
+
+inline int LedStrip::setCalibration(const uint8_t * gamma,
+                                    uint8_t r_trim, uint8_t g_trim, uint8_t b_trim)
+{
+    return led_strip_calibration_set(this->led_strip, gamma, r_trim, g_trim, b_trim);
+}
+
+inline int LedStrip::setCalibrationTables(const uint8_t * r, const uint8_t * g, const uint8_t * b)
+{
+    return led_strip_calibration_set_tables(this->led_strip, r, g, b);
+}
+
+inline void LedStrip::disableCalibration()
+{
+    led_strip_calibration_disable(this->led_strip);
+}
+
+inline int LedStrip::scatter(led_strip_update_t * updates, uint32_t count,
+                             led_strip_update_t * scratch,
+                             led_strip_scatter_changes_t * changes)
+{
+    return led_strip_scatter(this->led_strip, updates, count, scratch, changes);
+}
+
+inline LedStripParticles::LedStripParticles(uint32_t capacity, uint32_t num_leds)
+{
+    this->particles = led_strip_particles_create(capacity, num_leds);
+}
+
+inline LedStripParticles::~LedStripParticles()
+{
+    // NULL if create failed
+    if (this->particles) {
+        led_strip_particles_destroy(this->particles);
+    }
+}
+
+inline void LedStripParticles::setForces(int32_t gravity, uint8_t drag, uint8_t fade)
+{
+    led_strip_particles_set_forces(this->particles, gravity, drag, fade);
+}
+
+inline int LedStripParticles::spawn(int32_t position, int32_t velocity,
+                                    uint8_t r, uint8_t g, uint8_t b, uint16_t life)
+{
+    return led_strip_particles_spawn(this->particles, position, velocity, r, g, b, life);
+}
+
+inline uint32_t LedStripParticles::count()
+{
+    return led_strip_particles_count(this->particles);
+}
+
+inline void LedStripParticles::clear()
+{
+    led_strip_particles_clear(this->particles);
+}
+
+inline void LedStripParticles::update()
+{
+    led_strip_particles_update(this->particles);
+}
+
+inline void LedStripParticles::render(LedStrip & strip)
+{
+    led_strip_particles_render(this->particles, strip.led_strip);
+}
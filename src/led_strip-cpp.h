@@ -9,6 +9,16 @@
 
 #include "led_strip.h"
 #include "led_strip_struct.h"
+#include "led_strip_snapshot.h"
+#include "led_strip_protocol.h"
+#include "led_strip_view.h"
+#include "led_strip_math.h"
+#include "led_strip_power.h"
+#include "led_strip_particles.h"
+#include "led_strip_calibration.h"
+#include "led_strip_scatter.h"
+
+#include <stddef.h> // for NULL
 
 class LedStrip
 {
@@ -33,6 +43,9 @@ public:
                                            uint8_t *r, uint8_t *g, uint8_t *b,
                                            uint8_t *brightness);
 
+    inline void setPixelsRgb(uint32_t first, uint32_t count, const uint8_t * rgb,
+                             uint8_t brightness);
+
     inline void setColorAndBrightness(uint8_t r, uint8_t g, uint8_t b,
                                       uint8_t brightness);
 
@@ -50,8 +63,176 @@ public:
 
     inline void rotateRight();
 
+    inline led_strip_snapshot_t * saveSnapshot();
+
+    inline int restoreSnapshot(const led_strip_snapshot_t * snapshot);
+
+    static inline void destroySnapshot(led_strip_snapshot_t * snapshot);
+
+    inline void scaleRange(uint32_t first, uint32_t count, uint8_t scale);
+
+    inline void blendRange(uint32_t first, uint32_t count,
+                           uint8_t r, uint8_t g, uint8_t b, uint8_t amount);
+
+    static inline uint8_t scale8(uint8_t value, uint8_t scale);
+
+    static inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amount);
+
+    static inline uint8_t sin8(uint8_t theta);
+
+    static inline uint8_t cos8(uint8_t theta);
+
+    static inline uint8_t ease8(uint8_t t);
+
+    static inline uint8_t noise8(uint16_t x);
+
+    inline int enablePowerLimit(uint32_t budget_ma,
+                                const led_strip_power_model_t * model = NULL);
+
+    inline void disablePowerLimit();
+
+    inline void setPowerBudget(uint32_t budget_ma);
+
+    inline uint32_t getPowerEstimate();
+
+    inline uint16_t getPowerScale();
+
+    inline int setCalibration(const uint8_t * gamma,
+                              uint8_t r_trim = 255, uint8_t g_trim = 255, uint8_t b_trim = 255);
+
+    inline int setCalibrationTables(const uint8_t * r, const uint8_t * g, const uint8_t * b);
+
+    inline void disableCalibration();
+
+    inline int scatter(led_strip_update_t * updates, uint32_t count,
+                       led_strip_update_t * scratch = NULL,
+                       led_strip_scatter_changes_t * changes = NULL);
+
 protected:
+    // For backends, which set the show and destroy functions of the strip
+    inline LedStrip(uint32_t num_leds, const led_strip_protocol_t * protocol);
+
+    // Take ownership of a led strip object that was already created
+    inline LedStrip(led_strip_t * led_strip);
+
     led_strip_t * led_strip;
+
+    friend class LedStripView;
+    friend class LedStripParticles;
+};
+
+// A segment of another LedStrip. The parent must outlive the view.
+class LedStripView : public LedStrip
+{
+public:
+    inline LedStripView(LedStrip & parent, uint32_t offset, uint32_t length,
+                        bool reversed = false);
+};
+
+// Particles drawn additively onto a LedStrip, see led_strip_particles.h
+class LedStripParticles
+{
+public:
+    inline LedStripParticles(uint32_t capacity, uint32_t num_leds);
+
+    inline ~LedStripParticles();
+
+    inline void setForces(int32_t gravity, uint8_t drag, uint8_t fade);
+
+    inline int spawn(int32_t position, int32_t velocity,
+                     uint8_t r, uint8_t g, uint8_t b, uint16_t life);
+
+    inline uint32_t count();
+
+    inline void clear();
+
+    inline void update();
+
+    inline void render(LedStrip & strip);
+
+protected:
+    led_strip_particles_t * particles;
+};
+
+/*
+ * Traits of each LED chip, for use as the Protocol parameter of the backend
+ * templates, e.g. LedStripArduinoSpiWith<LedStripSk9822>. The frame sizes are compile-time constants,
+ * but a strip still encodes and shows through the led_strip_protocol_t that
+ * protocol() returns. That costs one indirect call per show, and the loop
+ * over the pixels is the same for either.
+ */
+
+struct LedStripApa102
+{
+    static const uint32_t headerLength = LED_STRIP_APA102_HEADER_LENGTH;
+    static const uint8_t footerByte = LED_STRIP_APA102_FOOTER_BYTE;
+    static const uint32_t bytesPerPixel = 4;
+    static const uint32_t maxFrequency = LED_STRIP_APA102_MAX_FREQUENCY;
+
+    static inline uint32_t footerLength(uint32_t num_leds)
+    {
+        return LED_STRIP_APA102_FOOTER_LENGTH(num_leds);
+    }
+
+    static inline const led_strip_protocol_t * protocol()
+    {
+        return &led_strip_protocol_apa102;
+    }
+};
+
+struct LedStripSk9822
+{
+    static const uint32_t headerLength = LED_STRIP_SK9822_HEADER_LENGTH;
+    static const uint8_t footerByte = LED_STRIP_SK9822_FOOTER_BYTE;
+    static const uint32_t bytesPerPixel = 4;
+    static const uint32_t maxFrequency = LED_STRIP_SK9822_MAX_FREQUENCY;
+
+    static inline uint32_t footerLength(uint32_t num_leds)
+    {
+        return LED_STRIP_SK9822_FOOTER_LENGTH(num_leds);
+    }
+
+    static inline const led_strip_protocol_t * protocol()
+    {
+        return &led_strip_protocol_sk9822;
+    }
+};
+
+struct LedStripHd107s
+{
+    static const uint32_t headerLength = LED_STRIP_HD107S_HEADER_LENGTH;
+    static const uint8_t footerByte = LED_STRIP_HD107S_FOOTER_BYTE;
+    static const uint32_t bytesPerPixel = 4;
+    static const uint32_t maxFrequency = LED_STRIP_HD107S_MAX_FREQUENCY;
+
+    static inline uint32_t footerLength(uint32_t num_leds)
+    {
+        return LED_STRIP_HD107S_FOOTER_LENGTH(num_leds);
+    }
+
+    static inline const led_strip_protocol_t * protocol()
+    {
+        return &led_strip_protocol_hd107s;
+    }
+};
+
+struct LedStripWs2801
+{
+    static const uint32_t headerLength = LED_STRIP_WS2801_HEADER_LENGTH;
+    static const uint8_t footerByte = LED_STRIP_WS2801_FOOTER_BYTE;
+    static const uint32_t bytesPerPixel = 3;
+    static const uint32_t maxFrequency = LED_STRIP_WS2801_MAX_FREQUENCY;
+
+    static inline uint32_t footerLength(uint32_t num_leds)
+    {
+        (void) num_leds;
+        return LED_STRIP_WS2801_FOOTER_LENGTH(num_leds);
+    }
+
+    static inline const led_strip_protocol_t * protocol()
+    {
+        return &led_strip_protocol_ws2801;
+    }
 };
 
 #include "led_strip-cpp-implementation.h"
@@ -6,14 +6,59 @@
 
 #include "led_strip.h"
 #include "led_strip_struct.h"
+#include "led_strip_snapshot.h"
+#include "led_strip_pixel.h"
+#include "led_strip_power_track.h"
+#include "led_strip_calibration.h"
 
 #include <assert.h>  // for assert
 #include <stdlib.h>  // for free
 #include <stddef.h>  // for NULL
 
-#define PIXEL_BRIGHTNESS_MASK 0x1F
-#define PIXEL_BRIGHTNESS_HIGH_BITS 0xE0
+// Where pixel p is stored. Only valid for p < num_leds.
+static inline uint32_t led_strip_index(const led_strip_t * led_strip, uint32_t p)
+{
+    return led_strip->reversed ? led_strip->num_leds - 1 - p : p;
+}
+
+// The whole-strip fills below can update the current estimate directly, except
+// through a view, which only covers part of the strip the estimate is over.
+static inline struct _led_strip_power_t * led_strip_power_for_fill(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (power && power->owner != led_strip) {
+        power->dirty = 1;
+        return NULL;
+    }
+    return power;
+}
+
+// Move every stored pixel one place towards the end, dropping the last one.
+static void led_strip_shift_up(led_strip_t * led_strip)
+{
+    for (uint32_t i = led_strip->num_leds - 1; i > 0; i--) {
+        uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
+        uint8_t * ptr_previous = (uint8_t*) &led_strip->pixels[i-1];
+        ptr[0] = ptr_previous[0];
+        ptr[1] = ptr_previous[1];
+        ptr[2] = ptr_previous[2];
+        ptr[3] = ptr_previous[3];
+    }
+}
 
+// Move every stored pixel one place towards the start, dropping the first one.
+static void led_strip_shift_down(led_strip_t * led_strip)
+{
+    for (uint32_t i = 0; i < led_strip->num_leds - 1; i++) {
+        uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
+        uint8_t * ptr_next = (uint8_t*) &led_strip->pixels[i+1];
+        ptr[0] = ptr_next[0];
+        ptr[1] = ptr_next[1];
+        ptr[2] = ptr_next[2];
+        ptr[3] = ptr_next[3];
+    }
+}
 
 void led_strip_destroy(led_strip_t * led_strip)
 {
@@ -22,31 +67,74 @@ void led_strip_destroy(led_strip_t * led_strip)
     // First destroy any backend specific data
     led_strip->destroy(led_strip);
 
-    // Then destroy everything else.
-    if (led_strip->pixels) {
-        free(led_strip->pixels);
-    }
+    led_strip_power_disable(led_strip);
+    led_strip_calibration_disable(led_strip);
 
-    if (led_strip->header_data) {
-        free(led_strip->header_data);
+    // Then destroy everything else. The buffers are in the same block as
+    // the strip, and strips in caller-provided memory are not freed.
+    if (led_strip->snapshot_cache) {
+        led_strip_snapshot_destroy(led_strip->snapshot_cache);
     }
 
-    if (led_strip->footer_data) {
-        free(led_strip->footer_data);
+    if (led_strip->owns_memory) {
+        free(led_strip);
     }
-
-    free(led_strip);
 }
 
 int led_strip_show(led_strip_t * led_strip)
 {
     assert(led_strip->show && "No show function was set in create function");
 
+    const uint32_t * pixels = led_strip->pixels;
+    uint16_t scale = LED_STRIP_POWER_SCALE_NONE;
+
+    // How far the colors must be scaled down so they don't draw too much
+    // current. It comes from the estimate, and the next pass over the
+    // pixels applies it.
+    if (led_strip->power) {
+        scale = led_strip_power_limit(led_strip);
+    }
+
+    // Correct the colors for the strip, with the scale in the tables
+    if (led_strip->calibration) {
+        pixels = led_strip_calibration_apply(led_strip, pixels, scale);
+        scale = LED_STRIP_POWER_SCALE_NONE;
+    }
+
+    // Pixels sent as they are have no pass to fold the scale into, and the
+    // hook must see the colors that are sent
+    if (scale != LED_STRIP_POWER_SCALE_NONE &&
+        (!led_strip->protocol->encode || led_strip->show_hook)) {
+        pixels = led_strip_power_apply(led_strip, scale);
+        scale = LED_STRIP_POWER_SCALE_NONE;
+    }
+
+    if (led_strip->show_hook) {
+        led_strip->show_hook(led_strip, pixels, led_strip->show_hook_arg);
+    }
+
+    // Convert to wire format first unless the pixels are sent as they are
+    if (led_strip->protocol->encode) {
+        led_strip->protocol->encode(pixels, led_strip->tx_data, led_strip->num_leds, scale);
+    } else {
+        led_strip->tx_data = (uint8_t *) pixels;
+    }
+
     return led_strip->show(led_strip);
 }
 
 void led_strip_clear(led_strip_t * led_strip)
 {
+    struct _led_strip_power_t * power = led_strip_power_for_fill(led_strip);
+
+    if (power) {
+        power->sum[0] = (uint64_t) led_strip->num_leds * PIXEL_MAX_BRIGHTNESS;
+        for (int c = 1; c < 4; c++) {
+            power->sum[c] = 0;
+            power->weighted[c] = 0;
+        }
+    }
+
     for (uint32_t i = 0; i < led_strip->num_leds; i++) {
         uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
         ptr[0] = PIXEL_MAX_BRIGHTNESS | PIXEL_BRIGHTNESS_HIGH_BITS;
@@ -62,14 +150,21 @@ void led_strip_set_pixel_color_and_brightness(led_strip_t * led_strip,
                                               uint8_t brightness)
 {
     if (p < led_strip->num_leds) {
-        uint8_t *ptr = (uint8_t*) &led_strip->pixels[p];
+        uint8_t *ptr = (uint8_t*) &led_strip->pixels[led_strip_index(led_strip, p)];
         if (brightness > PIXEL_MAX_BRIGHTNESS) {
             brightness = PIXEL_MAX_BRIGHTNESS;
         }
+        struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+        if (power) {
+            led_strip_power_remove(power, ptr);
+        }
         ptr[0] = brightness | PIXEL_BRIGHTNESS_HIGH_BITS;
         ptr[1] = b;
         ptr[2] = g;
         ptr[3] = r;
+        if (power) {
+            led_strip_power_add(power, ptr);
+        }
     }
 }
 
@@ -99,7 +194,7 @@ void led_strip_get_pixel_color_and_brightness(led_strip_t * led_strip,
                                               uint8_t *brightness)
 {
     if (p < led_strip->num_leds) {
-        uint8_t *ptr = (uint8_t*) &led_strip->pixels[p];
+        uint8_t *ptr = (uint8_t*) &led_strip->pixels[led_strip_index(led_strip, p)];
 
         if (r != NULL) {
             *r = ptr[3];
@@ -116,6 +211,52 @@ void led_strip_get_pixel_color_and_brightness(led_strip_t * led_strip,
     }
 }
 
+void led_strip_set_pixels_rgb(led_strip_t * led_strip,
+                              uint32_t first, uint32_t count,
+                              const uint8_t * rgb,
+                              uint8_t brightness)
+{
+    if (first >= led_strip->num_leds) {
+        return;
+    }
+    if (count > led_strip->num_leds - first) {
+        count = led_strip->num_leds - first;
+    }
+
+    brightness = led_strip_pixel_brightness_byte(brightness);
+
+    uint32_t * stored = &led_strip->pixels[led_strip->reversed ?
+                                           led_strip->num_leds - first - count : first];
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+    if (power) {
+        led_strip_power_remove_range(power, stored, count);
+    }
+
+    // Straight byte shuffle with no branches so it can be vectorized
+    if (!led_strip->reversed) {
+        uint8_t * ptr = (uint8_t*) stored;
+        for (uint32_t i = 0; i < count; i++) {
+            ptr[4*i + 0] = brightness;
+            ptr[4*i + 1] = rgb[3*i + 2];
+            ptr[4*i + 2] = rgb[3*i + 1];
+            ptr[4*i + 3] = rgb[3*i + 0];
+        }
+    } else {
+        uint8_t * ptr = (uint8_t*) stored;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t j = count - 1 - i;
+            ptr[4*j + 0] = brightness;
+            ptr[4*j + 1] = rgb[3*i + 2];
+            ptr[4*j + 2] = rgb[3*i + 1];
+            ptr[4*j + 3] = rgb[3*i + 0];
+        }
+    }
+
+    if (power) {
+        led_strip_power_add_range(power, stored, count);
+    }
+}
+
 void led_strip_set_color_and_brightness(led_strip_t * led_strip,
                                         uint8_t r, uint8_t g, uint8_t b,
                                         uint8_t brightness)
@@ -126,6 +267,20 @@ void led_strip_set_color_and_brightness(led_strip_t * led_strip,
         brightness = brightness | PIXEL_BRIGHTNESS_HIGH_BITS;
     }
 
+    struct _led_strip_power_t * power = led_strip_power_for_fill(led_strip);
+
+    if (power) {
+        uint64_t num_leds = led_strip->num_leds;
+        uint32_t level = brightness & PIXEL_BRIGHTNESS_MASK;
+        power->sum[0] = num_leds * level;
+        power->sum[1] = num_leds * b;
+        power->sum[2] = num_leds * g;
+        power->sum[3] = num_leds * r;
+        for (int c = 1; c < 4; c++) {
+            power->weighted[c] = power->sum[c] * level;
+        }
+    }
+
     for (uint32_t i = 0; i < led_strip->num_leds; i++) {
         uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
         ptr[0] = brightness;
@@ -138,6 +293,18 @@ void led_strip_set_color_and_brightness(led_strip_t * led_strip,
 void led_strip_set_color(led_strip_t * led_strip,
                          uint8_t r, uint8_t g, uint8_t b)
 {
+    struct _led_strip_power_t * power = led_strip_power_for_fill(led_strip);
+
+    if (power) {
+        uint64_t num_leds = led_strip->num_leds;
+        power->sum[1] = num_leds * b;
+        power->sum[2] = num_leds * g;
+        power->sum[3] = num_leds * r;
+        power->weighted[1] = power->sum[0] * b;
+        power->weighted[2] = power->sum[0] * g;
+        power->weighted[3] = power->sum[0] * r;
+    }
+
     for (uint32_t i = 0; i < led_strip->num_leds; i++) {
         uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
         // Ignore brightness
@@ -156,6 +323,16 @@ void led_strip_set_brightness(led_strip_t * led_strip,
         brightness = brightness | PIXEL_BRIGHTNESS_HIGH_BITS;
     }
 
+    struct _led_strip_power_t * power = led_strip_power_for_fill(led_strip);
+
+    if (power) {
+        uint32_t level = brightness & PIXEL_BRIGHTNESS_MASK;
+        power->sum[0] = (uint64_t) led_strip->num_leds * level;
+        for (int c = 1; c < 4; c++) {
+            power->weighted[c] = power->sum[c] * level;
+        }
+    }
+
     for (uint32_t i = 0; i < led_strip->num_leds; i++) {
         uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
         ptr[0] = brightness;
@@ -167,13 +344,21 @@ void led_strip_push_pixel_front(led_strip_t * led_strip,
                                 uint8_t r, uint8_t g, uint8_t b,
                                 uint8_t brightness)
 {
-    for (uint32_t i = led_strip->num_leds - 1; i > 0; i--) {
-        uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
-        uint8_t * ptr_previous = (uint8_t*) &led_strip->pixels[i-1];
-        ptr[0] = ptr_previous[0];
-        ptr[1] = ptr_previous[1];
-        ptr[2] = ptr_previous[2];
-        ptr[3] = ptr_previous[3];
+    uint32_t dropped = led_strip->reversed ? 0 : led_strip->num_leds - 1;
+    uint32_t * inserted = &led_strip->pixels[led_strip->num_leds - 1 - dropped];
+
+    // The dropped pixel no longer counts, and the pixel that is about to be
+    // overwritten counts twice until it is
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+    if (power) {
+        led_strip_power_remove(power, (uint8_t*) &led_strip->pixels[dropped]);
+        led_strip_power_add(power, (uint8_t*) inserted);
+    }
+
+    if (led_strip->reversed) {
+        led_strip_shift_down(led_strip);
+    } else {
+        led_strip_shift_up(led_strip);
     }
 
     // Set the first pixel to the desired color and brightness
@@ -184,13 +369,20 @@ void led_strip_push_pixel_back(led_strip_t * led_strip,
                                uint8_t r, uint8_t g, uint8_t b,
                                uint8_t brightness)
 {
-    for (uint32_t i = 0; i < led_strip->num_leds - 1; i++) {
-        uint8_t * ptr = (uint8_t*) &led_strip->pixels[i];
-        uint8_t * ptr_next = (uint8_t*) &led_strip->pixels[i+1];
-        ptr[0] = ptr_next[0];
-        ptr[1] = ptr_next[1];
-        ptr[2] = ptr_next[2];
-        ptr[3] = ptr_next[3];
+    uint32_t dropped = led_strip->reversed ? led_strip->num_leds - 1 : 0;
+    uint32_t * inserted = &led_strip->pixels[led_strip->num_leds - 1 - dropped];
+
+    // Same bookkeeping as led_strip_push_pixel_front
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+    if (power) {
+        led_strip_power_remove(power, (uint8_t*) &led_strip->pixels[dropped]);
+        led_strip_power_add(power, (uint8_t*) inserted);
+    }
+
+    if (led_strip->reversed) {
+        led_strip_shift_up(led_strip);
+    } else {
+        led_strip_shift_down(led_strip);
     }
 
     // Set the last pixel to the desired color and brightness
@@ -217,3 +409,10 @@ void led_strip_rotate_right(led_strip_t * led_strip)
     led_strip_push_pixel_front(led_strip, r, g, b, brightness);
 }
 
+void led_strip_set_show_hook(led_strip_t * led_strip,
+                             led_strip_show_hook_t hook,
+                             void * arg)
+{
+    led_strip->show_hook = hook;
+    led_strip->show_hook_arg = arg;
+}
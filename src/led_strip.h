@@ -103,6 +103,22 @@ void led_strip_get_pixel_color_and_brightness(led_strip_t * led_strip,
                                               uint8_t *r, uint8_t *g, uint8_t *b,
                                               uint8_t *brightness);
 
+/*
+@brief Set consecutive pixels from packed 8 bit RGB triplets, such as a row
+       of an RGB24 image. Pixels past the end of the strip are ignored.
+
+@param led_strip The led strip object.
+@param first  The index of the first pixel to set
+@param count  The number of pixels to set
+@param rgb  3 * count bytes, red first
+@param brightness  The global brightness of the pixels, independent of color.
+                   Max brightness is defined in PIXEL_MAX_BRIGHTNESS.
+*/
+void led_strip_set_pixels_rgb(led_strip_t * led_strip,
+                              uint32_t first, uint32_t count,
+                              const uint8_t * rgb,
+                              uint8_t brightness);
+
 /*
 @brief Set the whole strip to a given color and brightness
 
@@ -183,4 +199,30 @@ void led_strip_rotate_left(led_strip_t * led_strip);
 */
 void led_strip_rotate_right(led_strip_t * led_strip);
 
+/*
+@brief Called by led_strip_show with the frame that is about to be sent, after
+       current limiting and before encoding to the wire format.
+
+@param led_strip The led strip object being shown.
+@param pixels One word per LED in the order they are sent, in the internal
+             pixel format. Only valid during the call.
+@param arg The argument given to led_strip_set_show_hook.
+*/
+typedef void (*led_strip_show_hook_t)(led_strip_t * led_strip,
+                                      const uint32_t * pixels,
+                                      void * arg);
+
+/*
+@brief Call a function on every show of the strip, e.g. to record what is
+       sent. Replaces the previous hook. Views show through their parent, so
+       set the hook on the parent to see their frames.
+
+@param led_strip The led strip object.
+@param hook The function to call, or NULL for none.
+@param arg Passed to every call of the hook.
+*/
+void led_strip_set_show_hook(led_strip_t * led_strip,
+                             led_strip_show_hook_t hook,
+                             void * arg);
+
 #endif
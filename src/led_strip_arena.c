@@ -0,0 +1,41 @@
+/*!
+@file led_strip_arena.c
+
+@brief Implementation of the arena allocator.
+**/
+
+#include "led_strip_arena.h"
+
+#include <assert.h> // for assert
+
+
+void led_strip_arena_init(led_strip_arena_t * arena, void * buffer, size_t size)
+{
+    assert(((uintptr_t) buffer % LED_STRIP_ARENA_ALIGN) == 0 && "Arena memory is not aligned");
+
+    arena->base = (uint8_t *) buffer;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void * led_strip_arena_alloc(led_strip_arena_t * arena, size_t size)
+{
+    // Rounding up wraps around for sizes close to SIZE_MAX, so the size is
+    // checked before too
+    if (size > arena->size - arena->used ||
+        LED_STRIP_ARENA_SIZE(size) > arena->size - arena->used) {
+        return NULL;
+    }
+
+    size = LED_STRIP_ARENA_SIZE(size);
+
+    void * ptr = arena->base + arena->used;
+    arena->used += size;
+
+    return ptr;
+}
+
+void led_strip_arena_reset(led_strip_arena_t * arena)
+{
+    arena->used = 0;
+}
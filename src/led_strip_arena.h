@@ -0,0 +1,55 @@
+/*!
+@file led_strip_arena.h
+
+@brief A simple bump allocator over caller-provided memory. Strips created
+       in an arena share one contiguous block, need no heap, and are all
+       released at once with led_strip_arena_reset.
+**/
+
+#ifndef LED_STRIP_ARENA_H
+#define LED_STRIP_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Alignment of every allocation in an arena.
+#define LED_STRIP_ARENA_ALIGN 8
+
+// Size of an allocation rounded up to the arena alignment.
+#define LED_STRIP_ARENA_SIZE(size) \
+    (((size) + LED_STRIP_ARENA_ALIGN - 1) & ~((size_t) LED_STRIP_ARENA_ALIGN - 1))
+
+typedef struct led_strip_arena_t {
+    uint8_t * base;
+    size_t size;
+    size_t used;
+} led_strip_arena_t;
+
+/*
+@brief Use a block of memory as an arena.
+
+@param arena The arena object.
+@param buffer The memory, aligned to LED_STRIP_ARENA_ALIGN. Must outlive
+              everything created in the arena.
+@param size The size of the memory in bytes.
+*/
+void led_strip_arena_init(led_strip_arena_t * arena, void * buffer, size_t size);
+
+/*
+@brief Take memory from the arena.
+
+@param arena The arena object.
+@param size The number of bytes.
+@return A pointer aligned to LED_STRIP_ARENA_ALIGN or NULL if the arena is full
+*/
+void * led_strip_arena_alloc(led_strip_arena_t * arena, size_t size);
+
+/*
+@brief Release everything taken from the arena. Strips created in it must
+       have been destroyed first.
+
+@param arena The arena object.
+*/
+void led_strip_arena_reset(led_strip_arena_t * arena);
+
+#endif
@@ -0,0 +1,311 @@
+/*!
+@file led_strip_batch.c
+
+@brief Implementation of recorded operation batches.
+**/
+
+#include "led_strip_batch.h"
+#include "led_strip_struct.h"
+#include "led_strip_pixel.h"
+#include "led_strip_power_track.h"
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy
+#include <stddef.h> // for NULL
+
+#define BATCH_OP_FILL 0
+#define BATCH_OP_SHIFT_LEFT 1  // Pixel i takes the value of pixel i+1
+#define BATCH_OP_SHIFT_RIGHT 2 // Pixel i takes the value of pixel i-1
+
+#define BATCH_MASK_ALL 0xFFFFFFFF
+
+typedef struct led_strip_batch_op_t {
+    uint8_t type;
+    uint8_t rotate; // Shifts only. Wrap around instead of inserting value.
+    uint32_t first; // Fills only. First pixel of the range.
+    uint32_t count; // Fills only. Number of pixels in the range.
+    uint32_t value; // Packed pixel that is filled or inserted
+    uint32_t mask;  // Bytes of value that are written
+} led_strip_batch_op_t;
+
+struct _led_strip_batch_t {
+    led_strip_t * led_strip;
+    uint32_t * source; // Copy of the pixels, used when operations move them
+    uint32_t color_mask;
+    uint32_t brightness_mask;
+    uint32_t num_ops;
+    uint32_t max_ops;
+    led_strip_batch_op_t * ops;
+};
+
+
+led_strip_batch_t * led_strip_batch_create(led_strip_t * led_strip, uint32_t max_ops)
+{
+    // The operations are stored right after the batch
+    led_strip_batch_t * batch = (led_strip_batch_t *)
+        malloc(sizeof(led_strip_batch_t) + max_ops * sizeof(led_strip_batch_op_t));
+
+    if (!batch) {
+        return NULL;
+    }
+
+    batch->source = (uint32_t *) malloc(led_strip->num_leds * sizeof(uint32_t));
+
+    if (!batch->source) {
+        free(batch);
+        return NULL;
+    }
+
+    batch->led_strip = led_strip;
+    batch->color_mask = led_strip_pixel_pack(0, 0xFF, 0xFF, 0xFF);
+    batch->brightness_mask = led_strip_pixel_pack(0xFF, 0, 0, 0);
+    batch->num_ops = 0;
+    batch->max_ops = max_ops;
+    batch->ops = (led_strip_batch_op_t *) (batch + 1);
+
+    return batch;
+}
+
+void led_strip_batch_destroy(led_strip_batch_t * batch)
+{
+    free(batch->source);
+    free(batch);
+}
+
+void led_strip_batch_reset(led_strip_batch_t * batch)
+{
+    batch->num_ops = 0;
+}
+
+static int led_strip_batch_add_fill(led_strip_batch_t * batch,
+                                    uint32_t first, uint32_t count,
+                                    uint32_t value, uint32_t mask)
+{
+    uint32_t num_leds = batch->led_strip->num_leds;
+
+    if (first >= num_leds) {
+        return 0;
+    }
+    if (count > num_leds - first) {
+        count = num_leds - first;
+    }
+    if (batch->led_strip->reversed) {
+        first = num_leds - first - count;
+    }
+
+    if (count == num_leds) {
+        // The fill overwrites these bytes of every pixel, so earlier fills
+        // of the same bytes can never be seen.
+        if (mask == BATCH_MASK_ALL) {
+            batch->num_ops = 0;
+        } else {
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < batch->num_ops; i++) {
+                led_strip_batch_op_t * op = &batch->ops[i];
+                if (op->type != BATCH_OP_FILL || (op->mask & ~mask) != 0) {
+                    batch->ops[kept++] = *op;
+                }
+            }
+            batch->num_ops = kept;
+        }
+    }
+
+    if (batch->num_ops == batch->max_ops) {
+        return -1;
+    }
+
+    led_strip_batch_op_t * op = &batch->ops[batch->num_ops++];
+    op->type = BATCH_OP_FILL;
+    op->rotate = 0;
+    op->first = first;
+    op->count = count;
+    op->value = value & mask;
+    op->mask = mask;
+
+    return 0;
+}
+
+static int led_strip_batch_add_shift(led_strip_batch_t * batch, uint8_t type,
+                                     uint8_t rotate, uint32_t value)
+{
+    if (batch->num_ops == batch->max_ops) {
+        return -1;
+    }
+
+    // Operations work on stored pixels, which run the other way on reversed strips
+    if (batch->led_strip->reversed) {
+        type = (type == BATCH_OP_SHIFT_LEFT) ? BATCH_OP_SHIFT_RIGHT : BATCH_OP_SHIFT_LEFT;
+    }
+
+    led_strip_batch_op_t * op = &batch->ops[batch->num_ops++];
+    op->type = type;
+    op->rotate = rotate;
+    op->first = 0;
+    op->count = 0;
+    op->value = value;
+    op->mask = BATCH_MASK_ALL;
+
+    return 0;
+}
+
+void led_strip_batch_apply(led_strip_batch_t * batch)
+{
+    led_strip_t * led_strip = batch->led_strip;
+    const led_strip_batch_op_t * ops = batch->ops;
+    uint32_t num_ops = batch->num_ops;
+    uint32_t last = led_strip->num_leds - 1;
+    const uint32_t * source = led_strip->pixels;
+
+    if (num_ops == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < num_ops; i++) {
+        if (ops[i].type != BATCH_OP_FILL) {
+            // Pixels move, so keep the original values around to read from
+            memcpy(batch->source, led_strip->pixels, led_strip->num_leds * sizeof(uint32_t));
+            source = batch->source;
+            break;
+        }
+    }
+
+    for (uint32_t p = 0; p <= last; p++) {
+        // Walk the operations backwards to find which bytes are set by an
+        // operation and where the rest of the pixel comes from.
+        uint32_t value = 0;
+        uint32_t known = 0;
+        uint32_t from = p;
+
+        for (uint32_t i = num_ops; i-- > 0 && known != BATCH_MASK_ALL; ) {
+            const led_strip_batch_op_t * op = &ops[i];
+
+            if (op->type == BATCH_OP_FILL) {
+                if (from - op->first < op->count) {
+                    value |= op->value & ~known;
+                    known |= op->mask;
+                }
+            } else if (op->type == BATCH_OP_SHIFT_LEFT) {
+                if (from < last) {
+                    from++;
+                } else if (op->rotate) {
+                    from = 0;
+                } else {
+                    value |= op->value & ~known;
+                    known = BATCH_MASK_ALL;
+                }
+            } else {
+                if (from > 0) {
+                    from--;
+                } else if (op->rotate) {
+                    from = last;
+                } else {
+                    value |= op->value & ~known;
+                    known = BATCH_MASK_ALL;
+                }
+            }
+        }
+
+        led_strip->pixels[p] = (source[from] & ~known) | value;
+    }
+
+    led_strip_power_invalidate(led_strip_power_of(led_strip));
+
+    batch->num_ops = 0;
+}
+
+int led_strip_batch_set_pixel_color_and_brightness(led_strip_batch_t * batch,
+                                                   uint32_t p,
+                                                   uint8_t r, uint8_t g, uint8_t b,
+                                                   uint8_t brightness)
+{
+    return led_strip_batch_set_range_color_and_brightness(batch, p, 1, r, g, b, brightness);
+}
+
+int led_strip_batch_set_pixel_color(led_strip_batch_t * batch,
+                                    uint32_t p,
+                                    uint8_t r, uint8_t g, uint8_t b)
+{
+    return led_strip_batch_set_range_color(batch, p, 1, r, g, b);
+}
+
+int led_strip_batch_set_pixel_brightness(led_strip_batch_t * batch,
+                                         uint32_t p,
+                                         uint8_t brightness)
+{
+    return led_strip_batch_set_range_brightness(batch, p, 1, brightness);
+}
+
+int led_strip_batch_set_color_and_brightness(led_strip_batch_t * batch,
+                                             uint8_t r, uint8_t g, uint8_t b,
+                                             uint8_t brightness)
+{
+    return led_strip_batch_set_range_color_and_brightness(batch, 0, batch->led_strip->num_leds,
+                                                          r, g, b, brightness);
+}
+
+int led_strip_batch_set_color(led_strip_batch_t * batch,
+                              uint8_t r, uint8_t g, uint8_t b)
+{
+    return led_strip_batch_set_range_color(batch, 0, batch->led_strip->num_leds, r, g, b);
+}
+
+int led_strip_batch_set_brightness(led_strip_batch_t * batch,
+                                   uint8_t brightness)
+{
+    return led_strip_batch_set_range_brightness(batch, 0, batch->led_strip->num_leds,
+                                                brightness);
+}
+
+int led_strip_batch_push_pixel_front(led_strip_batch_t * batch,
+                                     uint8_t r, uint8_t g, uint8_t b,
+                                     uint8_t brightness)
+{
+    return led_strip_batch_add_shift(batch, BATCH_OP_SHIFT_RIGHT, 0,
+        led_strip_pixel_pack(led_strip_pixel_brightness_byte(brightness), b, g, r));
+}
+
+int led_strip_batch_push_pixel_back(led_strip_batch_t * batch,
+                                    uint8_t r, uint8_t g, uint8_t b,
+                                    uint8_t brightness)
+{
+    return led_strip_batch_add_shift(batch, BATCH_OP_SHIFT_LEFT, 0,
+        led_strip_pixel_pack(led_strip_pixel_brightness_byte(brightness), b, g, r));
+}
+
+int led_strip_batch_rotate_left(led_strip_batch_t * batch)
+{
+    return led_strip_batch_add_shift(batch, BATCH_OP_SHIFT_LEFT, 1, 0);
+}
+
+int led_strip_batch_rotate_right(led_strip_batch_t * batch)
+{
+    return led_strip_batch_add_shift(batch, BATCH_OP_SHIFT_RIGHT, 1, 0);
+}
+
+int led_strip_batch_set_range_color_and_brightness(led_strip_batch_t * batch,
+                                                   uint32_t first, uint32_t count,
+                                                   uint8_t r, uint8_t g, uint8_t b,
+                                                   uint8_t brightness)
+{
+    return led_strip_batch_add_fill(batch, first, count,
+        led_strip_pixel_pack(led_strip_pixel_brightness_byte(brightness), b, g, r),
+        BATCH_MASK_ALL);
+}
+
+int led_strip_batch_set_range_color(led_strip_batch_t * batch,
+                                    uint32_t first, uint32_t count,
+                                    uint8_t r, uint8_t g, uint8_t b)
+{
+    return led_strip_batch_add_fill(batch, first, count,
+                                    led_strip_pixel_pack(0, b, g, r),
+                                    batch->color_mask);
+}
+
+int led_strip_batch_set_range_brightness(led_strip_batch_t * batch,
+                                         uint32_t first, uint32_t count,
+                                         uint8_t brightness)
+{
+    return led_strip_batch_add_fill(batch, first, count,
+        led_strip_pixel_pack(led_strip_pixel_brightness_byte(brightness), 0, 0, 0),
+        batch->brightness_mask);
+}
@@ -0,0 +1,137 @@
+/*!
+@file led_strip_batch.h
+
+@brief Record a sequence of led strip operations and apply them in a single
+       pass over the pixels. Operations that are completely overwritten by a
+       later one are dropped when they are recorded.
+**/
+
+#ifndef LED_STRIP_BATCH_H
+#define LED_STRIP_BATCH_H
+
+#include "led_strip.h"
+
+// Opaque data structure containing the recorded operations.
+typedef struct _led_strip_batch_t led_strip_batch_t;
+
+/*
+@brief Create an empty batch for a strip.
+
+@param led_strip The led strip object the batch is applied to.
+@param max_ops The maximum number of operations the batch can hold.
+@return A pointer to the allocated batch or NULL on allocation error
+*/
+led_strip_batch_t * led_strip_batch_create(led_strip_t * led_strip, uint32_t max_ops);
+
+/*
+@brief Destroy the batch and free all resources.
+
+@param batch The batch object.
+*/
+void led_strip_batch_destroy(led_strip_batch_t * batch);
+
+/*
+@brief Remove all recorded operations without applying them.
+
+@param batch The batch object.
+*/
+void led_strip_batch_reset(led_strip_batch_t * batch);
+
+/*
+@brief Apply all recorded operations to the strip in one pass and remove them
+       from the batch. Just modifies the buffer and does not write to the strip.
+
+@param batch The batch object.
+*/
+void led_strip_batch_apply(led_strip_batch_t * batch);
+
+/*
+ * The following functions record the led_strip.h function of the same name.
+ * They return -1 if the batch is full.
+ */
+
+int led_strip_batch_set_pixel_color_and_brightness(led_strip_batch_t * batch,
+                                                   uint32_t p,
+                                                   uint8_t r, uint8_t g, uint8_t b,
+                                                   uint8_t brightness);
+
+int led_strip_batch_set_pixel_color(led_strip_batch_t * batch,
+                                    uint32_t p,
+                                    uint8_t r, uint8_t g, uint8_t b);
+
+int led_strip_batch_set_pixel_brightness(led_strip_batch_t * batch,
+                                         uint32_t p,
+                                         uint8_t brightness);
+
+int led_strip_batch_set_color_and_brightness(led_strip_batch_t * batch,
+                                             uint8_t r, uint8_t g, uint8_t b,
+                                             uint8_t brightness);
+
+int led_strip_batch_set_color(led_strip_batch_t * batch,
+                              uint8_t r, uint8_t g, uint8_t b);
+
+int led_strip_batch_set_brightness(led_strip_batch_t * batch,
+                                   uint8_t brightness);
+
+int led_strip_batch_push_pixel_front(led_strip_batch_t * batch,
+                                     uint8_t r, uint8_t g, uint8_t b,
+                                     uint8_t brightness);
+
+int led_strip_batch_push_pixel_back(led_strip_batch_t * batch,
+                                    uint8_t r, uint8_t g, uint8_t b,
+                                    uint8_t brightness);
+
+int led_strip_batch_rotate_left(led_strip_batch_t * batch);
+
+int led_strip_batch_rotate_right(led_strip_batch_t * batch);
+
+/*
+@brief Record setting a range of pixels to a given color and brightness.
+
+@param batch The batch object.
+@param first  The index of the first pixel in the range
+@param count  The number of pixels in the range
+@param r  red
+@param g  green
+@param b  blue
+@param brightness  The global brightness of the pixels, independent of color.
+                   Max brightness is defined in PIXEL_MAX_BRIGHTNESS.
+@return -1 if the batch is full
+*/
+int led_strip_batch_set_range_color_and_brightness(led_strip_batch_t * batch,
+                                                   uint32_t first, uint32_t count,
+                                                   uint8_t r, uint8_t g, uint8_t b,
+                                                   uint8_t brightness);
+
+/*
+@brief Record setting a range of pixels to a given color. Does not change
+       brightness.
+
+@param batch The batch object.
+@param first  The index of the first pixel in the range
+@param count  The number of pixels in the range
+@param r  red
+@param g  green
+@param b  blue
+@return -1 if the batch is full
+*/
+int led_strip_batch_set_range_color(led_strip_batch_t * batch,
+                                    uint32_t first, uint32_t count,
+                                    uint8_t r, uint8_t g, uint8_t b);
+
+/*
+@brief Record setting the brightness of a range of pixels. Does not change
+       color.
+
+@param batch The batch object.
+@param first  The index of the first pixel in the range
+@param count  The number of pixels in the range
+@param brightness  The global brightness of the pixels, independent of color.
+                   Max brightness is defined in PIXEL_MAX_BRIGHTNESS.
+@return -1 if the batch is full
+*/
+int led_strip_batch_set_range_brightness(led_strip_batch_t * batch,
+                                         uint32_t first, uint32_t count,
+                                         uint8_t brightness);
+
+#endif
@@ -0,0 +1,175 @@
+/*!
+@file led_strip_calibration.c
+
+@brief Implementation of the gamma tables and the calibration pass.
+**/
+
+#include "led_strip_calibration.h"
+#include "led_strip_struct.h"
+#include "led_strip_math.h"
+#include "led_strip_power.h"
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy
+
+const uint8_t led_strip_gamma_2_2[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+const uint8_t led_strip_gamma_2_8[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+      5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+     10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+     17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+     25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+     37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+     51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+     69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+     90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+    115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+    144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+    177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+    215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255
+};
+
+struct _led_strip_calibration_t {
+    uint8_t r[256];
+    uint8_t g[256];
+    uint8_t b[256];
+    uint8_t sent_r[256]; // The tables times the scale of the power limit
+    uint8_t sent_g[256];
+    uint8_t sent_b[256];
+    uint32_t sent_scale; // The scale the sent tables were made for
+    uint32_t * tx; // The corrected frame, in the same block after the tables
+};
+
+// Any value above LED_STRIP_POWER_SCALE_NONE, so the sent tables are redone
+#define CALIBRATION_SCALE_STALE 0xFFFFFFFFu
+
+// Allocate the tables and the frame buffer on first use. The caller fills
+// in the tables.
+static struct _led_strip_calibration_t * led_strip_calibration_get(led_strip_t * led_strip)
+{
+    // Views are sent by the strip they are a range of, which would not use
+    // their tables
+    if (led_strip->parent) {
+        return NULL;
+    }
+
+    if (!led_strip->calibration) {
+        struct _led_strip_calibration_t * calibration = (struct _led_strip_calibration_t *)
+            malloc(sizeof(struct _led_strip_calibration_t) +
+                   led_strip->num_leds * sizeof(uint32_t));
+
+        if (!calibration) {
+            return NULL;
+        }
+
+        calibration->tx = (uint32_t *) (calibration + 1);
+        led_strip->calibration = calibration;
+    }
+
+    led_strip->calibration->sent_scale = CALIBRATION_SCALE_STALE;
+
+    return led_strip->calibration;
+}
+
+int led_strip_calibration_set(led_strip_t * led_strip,
+                              const uint8_t * gamma,
+                              uint8_t r_trim, uint8_t g_trim, uint8_t b_trim)
+{
+    struct _led_strip_calibration_t * calibration = led_strip_calibration_get(led_strip);
+
+    if (!calibration) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint8_t value = gamma ? gamma[i] : (uint8_t) i;
+        calibration->r[i] = led_strip_scale8(value, r_trim);
+        calibration->g[i] = led_strip_scale8(value, g_trim);
+        calibration->b[i] = led_strip_scale8(value, b_trim);
+    }
+
+    return 0;
+}
+
+int led_strip_calibration_set_tables(led_strip_t * led_strip,
+                                     const uint8_t * r,
+                                     const uint8_t * g,
+                                     const uint8_t * b)
+{
+    struct _led_strip_calibration_t * calibration = led_strip_calibration_get(led_strip);
+
+    if (!calibration) {
+        return -1;
+    }
+
+    memcpy(calibration->r, r, 256);
+    memcpy(calibration->g, g, 256);
+    memcpy(calibration->b, b, 256);
+
+    return 0;
+}
+
+void led_strip_calibration_disable(led_strip_t * led_strip)
+{
+    if (!led_strip->calibration) {
+        return;
+    }
+
+    // Send the pixels as they are again
+    if (!led_strip->protocol->encode) {
+        led_strip->tx_data = (uint8_t *) led_strip->pixels;
+    }
+
+    free(led_strip->calibration);
+    led_strip->calibration = NULL;
+}
+
+const uint32_t * led_strip_calibration_apply(led_strip_t * led_strip,
+                                             const uint32_t * pixels,
+                                             uint16_t scale)
+{
+    struct _led_strip_calibration_t * calibration = led_strip->calibration;
+    const uint8_t * in = (const uint8_t *) pixels;
+    uint8_t * out = (uint8_t *) calibration->tx;
+    uint32_t num_leds = led_strip->num_leds;
+
+    // Scaling the 768 table entries saves scaling every pixel
+    if (calibration->sent_scale != scale) {
+        for (uint32_t i = 0; i < 256; i++) {
+            calibration->sent_r[i] = (uint8_t) ((calibration->r[i] * scale) >> 8);
+            calibration->sent_g[i] = (uint8_t) ((calibration->g[i] * scale) >> 8);
+            calibration->sent_b[i] = (uint8_t) ((calibration->b[i] * scale) >> 8);
+        }
+        calibration->sent_scale = scale;
+    }
+
+    for (uint32_t i = 0; i < num_leds; i++) {
+        out[4*i + 0] = in[4*i + 0];
+        out[4*i + 1] = calibration->sent_b[in[4*i + 1]];
+        out[4*i + 2] = calibration->sent_g[in[4*i + 2]];
+        out[4*i + 3] = calibration->sent_r[in[4*i + 3]];
+    }
+
+    return calibration->tx;
+}
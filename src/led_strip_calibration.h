@@ -0,0 +1,75 @@
+/*!
+@file led_strip_calibration.h
+
+@brief Gamma correction and white balance per strip. Effects set linear
+       colors, and show looks every color up in a table per channel on the
+       way to the wire. The pixels keep the linear colors, so reading them
+       back and fading or blending them works as before. The current
+       estimate of led_strip_power.h is of the colors before correction,
+       which is an upper bound for curves and trims that only lower them.
+**/
+
+#ifndef LED_STRIP_CALIBRATION_H
+#define LED_STRIP_CALIBRATION_H
+
+#include "led_strip.h"
+
+// 255 * (i / 255) ^ 2.2, about the sRGB curve.
+extern const uint8_t led_strip_gamma_2_2[256];
+
+// 255 * (i / 255) ^ 2.8, a common curve for LEDs.
+extern const uint8_t led_strip_gamma_2_8[256];
+
+/*
+@brief Correct the colors of a strip with a gamma curve and a trim per
+       channel. Replaces any earlier calibration. Views are corrected by the
+       tables of the strip they are a range of.
+
+@param led_strip The led strip object, not a view.
+@param gamma A 256 entry curve like led_strip_gamma_2_2, or NULL for linear.
+@param r_trim The fraction of red to keep after the curve, 255 for all.
+@param g_trim The fraction of green to keep after the curve, 255 for all.
+@param b_trim The fraction of blue to keep after the curve, 255 for all.
+@return 0 on success, -1 for a view or on allocation error
+*/
+int led_strip_calibration_set(led_strip_t * led_strip,
+                              const uint8_t * gamma,
+                              uint8_t r_trim, uint8_t g_trim, uint8_t b_trim);
+
+/*
+@brief Correct the colors of a strip with any table per channel, e.g. one
+       measured for the strip.
+
+@param led_strip The led strip object, not a view.
+@param r The color sent for each red value, 256 entries.
+@param g The color sent for each green value, 256 entries.
+@param b The color sent for each blue value, 256 entries.
+@return 0 on success, -1 for a view or on allocation error
+*/
+int led_strip_calibration_set_tables(led_strip_t * led_strip,
+                                     const uint8_t * r,
+                                     const uint8_t * g,
+                                     const uint8_t * b);
+
+/*
+@brief Send the colors as they are set again. Destroy does this too.
+
+@param led_strip The led strip object.
+*/
+void led_strip_calibration_disable(led_strip_t * led_strip);
+
+/*
+@brief Write the calibrated colors of a frame to the buffer of the strip.
+       Called by led_strip_show.
+
+@param led_strip The led strip object, with a calibration set.
+@param pixels The frame to correct, num_leds pixels.
+@param scale The scale of the power limit applied after the tables, up to
+             LED_STRIP_POWER_SCALE_NONE.
+@return The corrected frame
+*/
+const uint32_t * led_strip_calibration_apply(led_strip_t * led_strip,
+                                             const uint32_t * pixels,
+                                             uint16_t scale);
+
+#endif
@@ -0,0 +1,146 @@
+/*!
+@file led_strip_interpolator.c
+
+@brief Implementation of keyframe interpolation.
+**/
+
+#include "led_strip_interpolator.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy
+#include <stddef.h> // for NULL
+
+struct _led_strip_interpolator_t {
+    led_strip_t * led_strip;
+    uint32_t * previous;
+    uint32_t * next;
+    uint32_t show_us; // Running average of how long a show takes
+};
+
+
+led_strip_interpolator_t * led_strip_interpolator_create(led_strip_t * led_strip)
+{
+    size_t bytes = led_strip->num_leds * sizeof(uint32_t);
+
+    led_strip_interpolator_t * interpolator = (led_strip_interpolator_t *)
+        malloc(sizeof(led_strip_interpolator_t));
+
+    if (!interpolator) {
+        return NULL;
+    }
+
+    interpolator->previous = (uint32_t *) malloc(bytes);
+    interpolator->next = (uint32_t *) malloc(bytes);
+
+    if (!interpolator->previous || !interpolator->next) {
+        led_strip_interpolator_destroy(interpolator);
+        return NULL;
+    }
+
+    interpolator->led_strip = led_strip;
+    interpolator->show_us = 0;
+    memcpy(interpolator->previous, led_strip->pixels, bytes);
+    memcpy(interpolator->next, led_strip->pixels, bytes);
+
+    return interpolator;
+}
+
+void led_strip_interpolator_destroy(led_strip_interpolator_t * interpolator)
+{
+    free(interpolator->previous);
+    free(interpolator->next);
+    free(interpolator);
+}
+
+void led_strip_interpolator_push_keyframe(led_strip_interpolator_t * interpolator)
+{
+    // Reuse the oldest keyframe buffer for the new one
+    uint32_t * oldest = interpolator->previous;
+
+    interpolator->previous = interpolator->next;
+    interpolator->next = oldest;
+    memcpy(interpolator->next, interpolator->led_strip->pixels,
+           interpolator->led_strip->num_leds * sizeof(uint32_t));
+}
+
+void led_strip_interpolator_render(led_strip_interpolator_t * interpolator,
+                                   uint16_t weight)
+{
+    const uint32_t * previous = interpolator->previous;
+    const uint32_t * next = interpolator->next;
+    uint32_t * pixels = interpolator->led_strip->pixels;
+    uint32_t num_leds = interpolator->led_strip->num_leds;
+
+    if (weight > LED_STRIP_INTERPOLATOR_WEIGHT_MAX) {
+        weight = LED_STRIP_INTERPOLATOR_WEIGHT_MAX;
+    }
+
+    uint32_t w_next = weight;
+    uint32_t w_previous = LED_STRIP_INTERPOLATOR_WEIGHT_MAX - weight;
+
+    // Blend all four bytes of a pixel at once in 8.8 fixed point, two bytes
+    // per multiply. Each 16 bit lane holds at most 255 * 256, so lanes never
+    // carry into each other, and the loop has no branches so the compiler can
+    // vectorize it. The brightness high bits are kept because a blend of two
+    // bytes >= 0xE0 is also >= 0xE0.
+    for (uint32_t i = 0; i < num_leds; i++) {
+        uint32_t a = previous[i];
+        uint32_t b = next[i];
+        uint32_t even = ((a & 0x00FF00FF) * w_previous + (b & 0x00FF00FF) * w_next) >> 8;
+        uint32_t odd = ((a >> 8) & 0x00FF00FF) * w_previous + ((b >> 8) & 0x00FF00FF) * w_next;
+        pixels[i] = (even & 0x00FF00FF) | (odd & 0xFF00FF00);
+    }
+
+    led_strip_power_invalidate(led_strip_power_of(interpolator->led_strip));
+}
+
+static int led_strip_interpolator_timed_show(led_strip_interpolator_t * interpolator,
+                                             led_strip_clock_us_t clock)
+{
+    uint32_t start = clock();
+    int ret = led_strip_show(interpolator->led_strip);
+    uint32_t duration = clock() - start;
+
+    if (interpolator->show_us == 0) {
+        interpolator->show_us = duration;
+    } else {
+        interpolator->show_us = (interpolator->show_us * 3 + duration) / 4;
+    }
+
+    return ret;
+}
+
+int led_strip_interpolator_show(led_strip_interpolator_t * interpolator,
+                                uint32_t interval_us,
+                                led_strip_clock_us_t clock)
+{
+    uint32_t start = clock();
+    int frames = 0;
+
+    for (;;) {
+        // Blend for the moment this frame will be visible
+        uint32_t visible = (clock() - start) + interpolator->show_us;
+
+        if (visible >= interval_us) {
+            break;
+        }
+
+        led_strip_interpolator_render(interpolator, (uint16_t)
+            (((uint64_t) visible * LED_STRIP_INTERPOLATOR_WEIGHT_MAX) / interval_us));
+
+        if (led_strip_interpolator_timed_show(interpolator, clock) < 0) {
+            return -1;
+        }
+        frames++;
+    }
+
+    led_strip_interpolator_render(interpolator, LED_STRIP_INTERPOLATOR_WEIGHT_MAX);
+
+    if (led_strip_interpolator_timed_show(interpolator, clock) < 0) {
+        return -1;
+    }
+
+    return frames + 1;
+}
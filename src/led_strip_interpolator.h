@@ -0,0 +1,74 @@
+/*!
+@file led_strip_interpolator.h
+
+@brief Generate intermediate frames between two keyframes. Content can be
+       rendered at a low rate while the strip is refreshed as fast as the
+       backend allows, with every refresh showing a blend of the previous and
+       next keyframe for the moment it becomes visible.
+**/
+
+#ifndef LED_STRIP_INTERPOLATOR_H
+#define LED_STRIP_INTERPOLATOR_H
+
+#include "led_strip.h"
+
+// Weight that selects the next keyframe only.
+#define LED_STRIP_INTERPOLATOR_WEIGHT_MAX 256
+
+// Opaque data structure containing the keyframes.
+typedef struct _led_strip_interpolator_t led_strip_interpolator_t;
+
+// Monotonic clock in microseconds, e.g. micros() on Arduino. May wrap around.
+typedef uint32_t (*led_strip_clock_us_t)(void);
+
+/*
+@brief Create an interpolator for a strip. Both keyframes start as the
+       current pixels of the strip.
+
+@param led_strip The led strip object.
+@return A pointer to the allocated interpolator or NULL on allocation error
+*/
+led_strip_interpolator_t * led_strip_interpolator_create(led_strip_t * led_strip);
+
+/*
+@brief Destroy the interpolator and free all resources.
+
+@param interpolator The interpolator object.
+*/
+void led_strip_interpolator_destroy(led_strip_interpolator_t * interpolator);
+
+/*
+@brief Make the current pixels of the strip the next keyframe. The old next
+       keyframe becomes the previous one.
+
+@param interpolator The interpolator object.
+*/
+void led_strip_interpolator_push_keyframe(led_strip_interpolator_t * interpolator);
+
+/*
+@brief Write a blend of the previous and next keyframe into the strip.
+       Does not write to the strip.
+
+@param interpolator The interpolator object.
+@param weight 0 for the previous keyframe up to
+              LED_STRIP_INTERPOLATOR_WEIGHT_MAX for the next keyframe.
+*/
+void led_strip_interpolator_render(led_strip_interpolator_t * interpolator,
+                                   uint16_t weight);
+
+/*
+@brief Show blended frames from the previous to the next keyframe for the
+       given interval, as fast as the strip can be shown. The blend of each
+       frame is chosen for when its show is expected to finish, using the
+       measured duration of earlier shows. The last frame is the next keyframe.
+
+@param interpolator The interpolator object.
+@param interval_us Time between the keyframes in microseconds.
+@param clock The clock used to time the frames.
+@return The number of frames shown or -1 on error
+*/
+int led_strip_interpolator_show(led_strip_interpolator_t * interpolator,
+                                uint32_t interval_us,
+                                led_strip_clock_us_t clock);
+
+#endif
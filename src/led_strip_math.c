@@ -0,0 +1,95 @@
+/*!
+@file led_strip_math.c
+
+@brief Implementation of the fixed point math tables and range functions.
+**/
+
+#include "led_strip_math.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+const uint8_t led_strip_sin8_table[65] = {
+      0,   3,   6,   9,  12,  16,  19,  22,
+     25,  28,  31,  34,  37,  40,  43,  46,
+     49,  51,  54,  57,  60,  63,  65,  68,
+     71,  73,  76,  78,  81,  83,  85,  88,
+     90,  92,  94,  96,  98, 100, 102, 104,
+    106, 107, 109, 111, 112, 113, 115, 116,
+    117, 118, 120, 121, 122, 122, 123, 124,
+    125, 125, 126, 126, 126, 127, 127, 127,
+    127
+};
+
+// Clamp a range to the strip and find where it is stored. Returns the first
+// stored pixel and updates count.
+static uint8_t * led_strip_math_range(led_strip_t * led_strip,
+                                      uint32_t first, uint32_t * count)
+{
+    if (first >= led_strip->num_leds) {
+        *count = 0;
+        return (uint8_t *) led_strip->pixels;
+    }
+    if (*count > led_strip->num_leds - first) {
+        *count = led_strip->num_leds - first;
+    }
+    if (led_strip->reversed) {
+        first = led_strip->num_leds - first - *count;
+    }
+
+    return (uint8_t *) &led_strip->pixels[first];
+}
+
+void led_strip_scale_range(led_strip_t * led_strip,
+                           uint32_t first, uint32_t count,
+                           uint8_t scale)
+{
+    uint8_t * ptr = led_strip_math_range(led_strip, first, &count);
+    uint16_t factor = (uint16_t) (scale + 1);
+
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (power) {
+        led_strip_power_remove_range(power, (uint32_t *) ptr, count);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ptr[4*i + 1] = (uint8_t) ((ptr[4*i + 1] * factor) >> 8);
+        ptr[4*i + 2] = (uint8_t) ((ptr[4*i + 2] * factor) >> 8);
+        ptr[4*i + 3] = (uint8_t) ((ptr[4*i + 3] * factor) >> 8);
+    }
+
+    if (power) {
+        led_strip_power_add_range(power, (uint32_t *) ptr, count);
+    }
+}
+
+void led_strip_blend_range(led_strip_t * led_strip,
+                           uint32_t first, uint32_t count,
+                           uint8_t r, uint8_t g, uint8_t b,
+                           uint8_t amount)
+{
+    uint8_t * ptr = led_strip_math_range(led_strip, first, &count);
+    uint8_t keep = (uint8_t) (255 - amount);
+
+    // The color's share is the same for every pixel. The products are done
+    // in uint16_t, as 255 * 255 overflows a 16 bit int.
+    uint16_t add_b = (uint16_t) ((uint16_t) b * amount);
+    uint16_t add_g = (uint16_t) ((uint16_t) g * amount);
+    uint16_t add_r = (uint16_t) ((uint16_t) r * amount);
+
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (power) {
+        led_strip_power_remove_range(power, (uint32_t *) ptr, count);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ptr[4*i + 1] = led_strip_div255((uint16_t) ((uint16_t) ptr[4*i + 1] * keep + add_b));
+        ptr[4*i + 2] = led_strip_div255((uint16_t) ((uint16_t) ptr[4*i + 2] * keep + add_g));
+        ptr[4*i + 3] = led_strip_div255((uint16_t) ((uint16_t) ptr[4*i + 3] * keep + add_r));
+    }
+
+    if (power) {
+        led_strip_power_add_range(power, (uint32_t *) ptr, count);
+    }
+}
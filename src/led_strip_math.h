@@ -0,0 +1,141 @@
+/*!
+@file led_strip_math.h
+
+@brief 8 bit fixed point math for effects on MCUs without an FPU or a
+       hardware divider. Nothing here divides, uses floating point or
+       branches on its input, so run time is the same for every pixel.
+       Angles are 0 to 255 for a full turn and fractions are 0 to 255 for
+       0 to 1.
+**/
+
+#ifndef LED_STRIP_MATH_H
+#define LED_STRIP_MATH_H
+
+#include "led_strip.h"
+
+// Quarter sine wave, 127 * sin(i * pi / 128) for i from 0 to 64.
+extern const uint8_t led_strip_sin8_table[65];
+
+/*
+@brief Scale a value by a fraction, value * (scale + 1) / 256. A scale of 255
+       keeps the value and 0 turns it off.
+*/
+static inline uint8_t led_strip_scale8(uint8_t value, uint8_t scale)
+{
+    return (uint8_t) (((uint16_t) value * (uint16_t) (scale + 1)) >> 8);
+}
+
+/*
+@brief Scale a 16 bit value by a 16 bit fraction, like led_strip_scale8.
+*/
+static inline uint16_t led_strip_scale16(uint16_t value, uint16_t scale)
+{
+    return (uint16_t) (((uint32_t) value * ((uint32_t) scale + 1)) >> 16);
+}
+
+/*
+@brief Divide by 255 with rounding down. Exact for x from 0 to 255 * 255.
+*/
+static inline uint8_t led_strip_div255(uint16_t x)
+{
+    return (uint8_t) (((uint32_t) x + 1 + (x >> 8)) >> 8);
+}
+
+/*
+@brief Blend two values. An amount of 0 gives a, 255 gives b.
+*/
+static inline uint8_t led_strip_blend8(uint8_t a, uint8_t b, uint8_t amount)
+{
+    return led_strip_div255((uint16_t) ((uint16_t) a * (uint8_t) (255 - amount) +
+                                        (uint16_t) b * amount));
+}
+
+/*
+@brief Sine of an angle. A full turn is 0 to 255, the result is 128 + 127 * sin
+       so it goes from 1 to 255 with 128 as zero.
+*/
+static inline uint8_t led_strip_sin8(uint8_t theta)
+{
+    // The second and fourth quarter read the table backwards
+    uint8_t mirror = (uint8_t) (0 - ((theta >> 6) & 1));
+    uint8_t index = (uint8_t) (((theta & 63) ^ (mirror & 63)) + (mirror & 1));
+    int16_t negative = (int16_t) (0 - (theta >> 7));
+    int16_t value = led_strip_sin8_table[index];
+
+    return (uint8_t) (128 + ((value ^ negative) - negative));
+}
+
+/*
+@brief Cosine of an angle, like led_strip_sin8.
+*/
+static inline uint8_t led_strip_cos8(uint8_t theta)
+{
+    return led_strip_sin8((uint8_t) (theta + 64));
+}
+
+/*
+@brief Ease in and out of a fraction, quadratic at both ends.
+*/
+static inline uint8_t led_strip_ease8(uint8_t t)
+{
+    // The second half is the first half turned around
+    uint8_t mirror = (uint8_t) (0 - (t >> 7));
+    uint8_t half = (uint8_t) (t ^ mirror);
+
+    return (uint8_t) ((uint8_t) (led_strip_scale8(half, half) << 1) ^ mirror);
+}
+
+/*
+@brief A pseudo random value for an integer, the same every time.
+*/
+static inline uint8_t led_strip_hash8(uint16_t x)
+{
+    uint16_t h = (uint16_t) (x * 0x9E37u);
+    h ^= h >> 7;
+    h = (uint16_t) (h * 0x2C1Bu);
+    return (uint8_t) (h >> 8);
+}
+
+/*
+@brief Smooth 1D value noise. Each step of 256 in x passes through one random
+       value, eased into the next.
+*/
+static inline uint8_t led_strip_noise8(uint16_t x)
+{
+    uint16_t cell = x >> 8;
+
+    return led_strip_blend8(led_strip_hash8(cell), led_strip_hash8((uint16_t) (cell + 1)),
+                            led_strip_ease8((uint8_t) x));
+}
+
+/*
+@brief Scale the color of a range of pixels, e.g. to fade it out. Brightness
+       is not changed. Does not write to the strip.
+
+@param led_strip The led strip object.
+@param first The first pixel of the range.
+@param count The number of pixels in the range. Clamped to the strip.
+@param scale The fraction to keep, 255 for all.
+*/
+void led_strip_scale_range(led_strip_t * led_strip,
+                           uint32_t first, uint32_t count,
+                           uint8_t scale);
+
+/*
+@brief Blend the color of a range of pixels towards a color. Brightness is
+       not changed. Does not write to the strip.
+
+@param led_strip The led strip object.
+@param first The first pixel of the range.
+@param count The number of pixels in the range. Clamped to the strip.
+@param r  red to blend towards
+@param g  green to blend towards
+@param b  blue to blend towards
+@param amount 0 keeps the pixels, 255 sets them to the color.
+*/
+void led_strip_blend_range(led_strip_t * led_strip,
+                           uint32_t first, uint32_t count,
+                           uint8_t r, uint8_t g, uint8_t b,
+                           uint8_t amount);
+
+#endif
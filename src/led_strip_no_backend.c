@@ -10,56 +10,117 @@
 
 #include <string.h> // for memset
 #include <assert.h> // for assert
-#include <stdlib.h> // for calloc
+#include <stdlib.h> // for malloc
 
 
+size_t led_strip_required_size(uint32_t num_leds,
+                               const led_strip_protocol_t * protocol)
+{
+    size_t size = LED_STRIP_ARENA_SIZE(sizeof(led_strip_t)) +
+                  LED_STRIP_ARENA_SIZE(num_leds * sizeof(uint32_t)) +
+                  LED_STRIP_ARENA_SIZE(protocol->header_len) +
+                  LED_STRIP_ARENA_SIZE(protocol->footer_len(num_leds));
+
+    // Protocols without an encoder send the pixels as they are
+    if (protocol->encode) {
+        size += LED_STRIP_ARENA_SIZE(num_leds * protocol->bytes_per_pixel);
+    }
+
+    return size;
+}
+
 led_strip_t * led_strip_create_no_backend(uint32_t num_leds)
+{
+    return led_strip_create_no_backend_protocol(num_leds, &led_strip_protocol_apa102);
+}
+
+led_strip_t * led_strip_create_no_backend_protocol(uint32_t num_leds,
+                                                   const led_strip_protocol_t * protocol)
 {
     assert(num_leds && "Enter a value > 0 for the number of LEDs.");
 
-    led_strip_t * led_strip = (led_strip_t *) malloc(sizeof(led_strip_t));
+    // Everything goes in a single block so destroy is one free
+    size_t size = led_strip_required_size(num_leds, protocol);
+    void * buffer = malloc(size);
 
-    if (!led_strip) {
-        goto led_strip_allocation_error;
+    if (!buffer) {
+        return NULL;
     }
 
-    led_strip->num_leds = num_leds;
-    led_strip->pixels = (uint32_t *) malloc(led_strip->num_leds * sizeof(uint32_t));
+    led_strip_t * led_strip = led_strip_create_no_backend_in(buffer, size, num_leds, protocol);
+    led_strip->owns_memory = 1;
 
-    if (!led_strip->pixels) {
-        goto led_strip_pixel_allocation_error;
-    }
+    return led_strip;
+}
 
-    // Header is all zeros
-    led_strip->header_data = (uint8_t *) calloc(HEADER_LENGTH_IN_BYTES, 1);
+led_strip_t * led_strip_create_no_backend_in(void * buffer, size_t size,
+                                             uint32_t num_leds,
+                                             const led_strip_protocol_t * protocol)
+{
+    led_strip_arena_t arena;
+
+    led_strip_arena_init(&arena, buffer, size);
 
-    if (!led_strip->header_data) {
-        goto led_strip_header_allocation_error;
+    return led_strip_create_no_backend_arena(&arena, num_leds, protocol);
+}
+
+led_strip_t * led_strip_create_no_backend_arena(led_strip_arena_t * arena,
+                                                uint32_t num_leds,
+                                                const led_strip_protocol_t * protocol)
+{
+    assert(num_leds && "Enter a value > 0 for the number of LEDs.");
+
+    size_t size = led_strip_required_size(num_leds, protocol);
+
+    if (size > arena->size - arena->used) {
+        return NULL;
     }
 
-    // Datasheet says 32*1 bits for footer, but testing shows we must use
-    // at least (num_leds + 1)/2 high values.
-    led_strip->footer_len = (led_strip->num_leds + 15)/16;
-    led_strip->footer_data = (uint8_t *) malloc(led_strip->footer_len);
+    // Cannot fail now that the size is checked
+    led_strip_t * led_strip = (led_strip_t *) led_strip_arena_alloc(arena, sizeof(led_strip_t));
 
-    if (!led_strip->footer_data) {
-        goto led_strip_footer_allocation_error;
+    led_strip->num_leds = num_leds;
+    led_strip->reversed = 0;
+    led_strip->owns_memory = 0;
+    led_strip->protocol = protocol;
+    led_strip->header_data = NULL;
+    led_strip->footer_data = NULL;
+    led_strip->show = NULL;
+    led_strip->destroy = NULL;
+    led_strip->backend_data = NULL;
+    led_strip->parent = NULL;
+    led_strip->snapshot_cache = NULL;
+    led_strip->power = NULL;
+    led_strip->calibration = NULL;
+    led_strip->show_hook = NULL;
+    led_strip->show_hook_arg = NULL;
+    led_strip->pixels = (uint32_t *) led_strip_arena_alloc(arena,
+                                                           num_leds * sizeof(uint32_t));
+
+    led_strip->tx_len = num_leds * protocol->bytes_per_pixel;
+    if (protocol->encode) {
+        led_strip->tx_data = (uint8_t *) led_strip_arena_alloc(arena, led_strip->tx_len);
+    } else {
+        led_strip->tx_data = (uint8_t *) led_strip->pixels;
     }
 
-    // Footer is all ones
-    memset(led_strip->footer_data, 0xFF, led_strip->footer_len);
+    // Header is all zeros
+    led_strip->header_len = protocol->header_len;
+    if (led_strip->header_len) {
+        led_strip->header_data = (uint8_t *) led_strip_arena_alloc(arena, led_strip->header_len);
+        memset(led_strip->header_data, 0, led_strip->header_len);
+    }
+
+    // Datasheet says 32*1 bits for footer, but testing shows we must use
+    // at least (num_leds + 1)/2 high values. See the protocol for each chip.
+    led_strip->footer_len = protocol->footer_len(num_leds);
+    if (led_strip->footer_len) {
+        led_strip->footer_data = (uint8_t *) led_strip_arena_alloc(arena, led_strip->footer_len);
+        memset(led_strip->footer_data, protocol->footer_byte, led_strip->footer_len);
+    }
 
     // Make sure the led strip is off
     led_strip_clear(led_strip);
 
     return led_strip;
-
-led_strip_footer_allocation_error:
-    free(led_strip->header_data);
-led_strip_header_allocation_error:
-    free(led_strip->pixels);
-led_strip_pixel_allocation_error:
-    free(led_strip);
-led_strip_allocation_error:
-    return NULL;
 }
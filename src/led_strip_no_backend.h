@@ -8,6 +8,8 @@
 #define LED_STRIP_NO_BACKEND_H
 
 #include "led_strip.h"
+#include "led_strip_protocol.h"
+#include "led_strip_arena.h"
 
 /*
 @brief Initialize the led strip without the backend. Every backend
@@ -18,4 +20,54 @@
 */
 led_strip_t * led_strip_create_no_backend(uint32_t num_leds);
 
+/*
+@brief Initialize the led strip without the backend for a given LED chip.
+
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_sk9822
+@return A pointer to the allocated led strip object
+*/
+led_strip_t * led_strip_create_no_backend_protocol(uint32_t num_leds,
+                                                   const led_strip_protocol_t * protocol);
+
+/*
+@brief The number of bytes needed to create a led strip in caller-provided
+       memory, for the strip and all of its buffers. Backend data is extra.
+
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_apa102
+@return The size in bytes
+*/
+size_t led_strip_required_size(uint32_t num_leds,
+                               const led_strip_protocol_t * protocol);
+
+/*
+@brief Initialize the led strip without the backend in caller-provided
+       memory. Nothing is allocated, and led_strip_destroy does not free the
+       memory.
+
+@param buffer The memory, aligned to LED_STRIP_ARENA_ALIGN.
+@param size The size of the memory, at least led_strip_required_size.
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_apa102
+@return A pointer to the led strip object or NULL if the memory is too small
+*/
+led_strip_t * led_strip_create_no_backend_in(void * buffer, size_t size,
+                                             uint32_t num_leds,
+                                             const led_strip_protocol_t * protocol);
+
+/*
+@brief Initialize the led strip without the backend in an arena. It takes
+       led_strip_required_size bytes from the arena, which are released with
+       led_strip_arena_reset.
+
+@param arena The arena object.
+@param num_leds The number of LEDs in the strip
+@param protocol The wire encoding, e.g. &led_strip_protocol_apa102
+@return A pointer to the led strip object or NULL if the arena is full
+*/
+led_strip_t * led_strip_create_no_backend_arena(led_strip_arena_t * arena,
+                                                uint32_t num_leds,
+                                                const led_strip_protocol_t * protocol);
+
 #endif
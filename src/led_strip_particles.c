@@ -0,0 +1,245 @@
+/*!
+@file led_strip_particles.c
+
+@brief Implementation of the particle system.
+**/
+
+#include "led_strip_particles.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+#include <stdlib.h> // for malloc
+#include <assert.h> // for assert
+
+struct _led_strip_particles_t {
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t num_leds;
+    uint8_t owns_memory;
+
+    int32_t gravity;
+    int32_t drag;  // Velocity is multiplied by drag / 256 per update
+    uint16_t fade; // Level is multiplied by fade / 256 per update
+
+    // One entry per particle, the first count are alive
+    int32_t * position;
+    int32_t * velocity;
+    uint16_t * life;
+    uint8_t * r;
+    uint8_t * g;
+    uint8_t * b;
+    uint8_t * level;
+};
+
+// Add with saturation at 255
+static inline uint8_t led_strip_particles_add8(uint8_t a, uint8_t b)
+{
+    uint16_t sum = (uint16_t) (a + b);
+    return (uint8_t) (sum | (0 - (sum >> 8)));
+}
+
+size_t led_strip_particles_required_size(uint32_t capacity)
+{
+    return LED_STRIP_ARENA_SIZE(sizeof(led_strip_particles_t)) +
+           2 * LED_STRIP_ARENA_SIZE(capacity * sizeof(int32_t)) +
+           LED_STRIP_ARENA_SIZE(capacity * sizeof(uint16_t)) +
+           4 * LED_STRIP_ARENA_SIZE(capacity);
+}
+
+led_strip_particles_t * led_strip_particles_create(uint32_t capacity, uint32_t num_leds)
+{
+    // Everything goes in a single block so destroy is one free
+    size_t size = led_strip_particles_required_size(capacity);
+    void * buffer = malloc(size);
+
+    if (!buffer) {
+        return NULL;
+    }
+
+    led_strip_arena_t arena;
+    led_strip_arena_init(&arena, buffer, size);
+
+    led_strip_particles_t * particles = led_strip_particles_create_arena(&arena, capacity, num_leds);
+    particles->owns_memory = 1;
+
+    return particles;
+}
+
+led_strip_particles_t * led_strip_particles_create_arena(led_strip_arena_t * arena,
+                                                         uint32_t capacity,
+                                                         uint32_t num_leds)
+{
+    assert(num_leds && num_leds <= INT32_MAX / LED_STRIP_PARTICLE_ONE &&
+           "Enter a value > 0 for the number of LEDs that fits a position.");
+
+    if (led_strip_particles_required_size(capacity) > arena->size - arena->used) {
+        return NULL;
+    }
+
+    // Cannot fail now that the size is checked
+    led_strip_particles_t * particles = (led_strip_particles_t *)
+        led_strip_arena_alloc(arena, sizeof(led_strip_particles_t));
+
+    particles->capacity = capacity;
+    particles->count = 0;
+    particles->num_leds = num_leds;
+    particles->owns_memory = 0;
+    particles->gravity = 0;
+    particles->drag = 256;
+    particles->fade = 256;
+    particles->position = (int32_t *) led_strip_arena_alloc(arena, capacity * sizeof(int32_t));
+    particles->velocity = (int32_t *) led_strip_arena_alloc(arena, capacity * sizeof(int32_t));
+    particles->life = (uint16_t *) led_strip_arena_alloc(arena, capacity * sizeof(uint16_t));
+    particles->r = (uint8_t *) led_strip_arena_alloc(arena, capacity);
+    particles->g = (uint8_t *) led_strip_arena_alloc(arena, capacity);
+    particles->b = (uint8_t *) led_strip_arena_alloc(arena, capacity);
+    particles->level = (uint8_t *) led_strip_arena_alloc(arena, capacity);
+
+    return particles;
+}
+
+void led_strip_particles_destroy(led_strip_particles_t * particles)
+{
+    if (particles->owns_memory) {
+        free(particles);
+    }
+}
+
+void led_strip_particles_set_forces(led_strip_particles_t * particles,
+                                    int32_t gravity, uint8_t drag, uint8_t fade)
+{
+    particles->gravity = gravity;
+    particles->drag = (int32_t) drag + 1;
+    particles->fade = (uint16_t) (fade + 1);
+}
+
+int led_strip_particles_spawn(led_strip_particles_t * particles,
+                              int32_t position, int32_t velocity,
+                              uint8_t r, uint8_t g, uint8_t b,
+                              uint16_t life)
+{
+    if (particles->count == particles->capacity || position < 0 ||
+        position >= (int32_t) particles->num_leds * LED_STRIP_PARTICLE_ONE) {
+        return -1;
+    }
+
+    uint32_t i = particles->count++;
+    particles->position[i] = position;
+    particles->velocity[i] = velocity;
+    particles->life[i] = life;
+    particles->r[i] = r;
+    particles->g[i] = g;
+    particles->b[i] = b;
+    particles->level[i] = 255;
+
+    return 0;
+}
+
+uint32_t led_strip_particles_count(led_strip_particles_t * particles)
+{
+    return particles->count;
+}
+
+void led_strip_particles_clear(led_strip_particles_t * particles)
+{
+    particles->count = 0;
+}
+
+void led_strip_particles_update(led_strip_particles_t * particles)
+{
+    uint32_t count = particles->count;
+    int32_t * position = particles->position;
+    int32_t * velocity = particles->velocity;
+    uint16_t * life = particles->life;
+    uint8_t * level = particles->level;
+    int32_t gravity = particles->gravity;
+    int32_t drag = particles->drag;
+    uint16_t fade = particles->fade;
+
+    // Without branches or calls, one property at a time, so each loop can be
+    // vectorized
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t v = (velocity[i] + gravity) * drag / 256;
+        velocity[i] = v;
+        position[i] += v;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        life[i] = (uint16_t) (life[i] - (life[i] != 0));
+        level[i] = (uint8_t) ((level[i] * fade) >> 8);
+    }
+
+    // Move the last particle into the place of each dead one. A negative
+    // position is a large unsigned one, so one compare finds both ends.
+    uint32_t end = particles->num_leds * LED_STRIP_PARTICLE_ONE;
+    uint32_t i = 0;
+    while (i < count) {
+        if ((uint32_t) position[i] < end && life[i] != 0 && level[i] != 0) {
+            i++;
+            continue;
+        }
+
+        count--;
+        position[i] = position[count];
+        velocity[i] = velocity[count];
+        life[i] = life[count];
+        particles->r[i] = particles->r[count];
+        particles->g[i] = particles->g[count];
+        particles->b[i] = particles->b[count];
+        level[i] = level[count];
+    }
+    particles->count = count;
+}
+
+void led_strip_particles_render(led_strip_particles_t * particles,
+                                led_strip_t * led_strip)
+{
+    uint32_t count = particles->count;
+    uint32_t num_leds = led_strip->num_leds;
+    uint8_t * pixels = (uint8_t *) led_strip->pixels;
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    // The next LED is stored after or, on a reversed strip, before this one
+    int32_t step = led_strip->reversed ? -4 : 4;
+
+    // Split every particle between the LED it is on and the next one
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t led = (uint32_t) particles->position[i] / LED_STRIP_PARTICLE_ONE;
+        uint16_t next = (uint16_t) ((uint32_t) particles->position[i] % LED_STRIP_PARTICLE_ONE);
+        uint16_t here = (uint16_t) (LED_STRIP_PARTICLE_ONE - next);
+        uint16_t level = (uint16_t) (particles->level[i] + 1);
+        uint16_t r = (uint16_t) ((particles->r[i] * level) >> 8);
+        uint16_t g = (uint16_t) ((particles->g[i] * level) >> 8);
+        uint16_t b = (uint16_t) ((particles->b[i] * level) >> 8);
+
+        // Particles past the end of a shorter strip are not drawn
+        if (led >= num_leds) {
+            continue;
+        }
+
+        uint8_t * ptr = pixels + 4 * (led_strip->reversed ? num_leds - 1 - led : led);
+        if (power) {
+            led_strip_power_remove(power, ptr);
+        }
+        ptr[1] = led_strip_particles_add8(ptr[1], (uint8_t) ((b * here) >> 8));
+        ptr[2] = led_strip_particles_add8(ptr[2], (uint8_t) ((g * here) >> 8));
+        ptr[3] = led_strip_particles_add8(ptr[3], (uint8_t) ((r * here) >> 8));
+        if (power) {
+            led_strip_power_add(power, ptr);
+        }
+
+        if (led + 1 >= num_leds) {
+            continue;
+        }
+
+        ptr += step;
+        if (power) {
+            led_strip_power_remove(power, ptr);
+        }
+        ptr[1] = led_strip_particles_add8(ptr[1], (uint8_t) ((b * next) >> 8));
+        ptr[2] = led_strip_particles_add8(ptr[2], (uint8_t) ((g * next) >> 8));
+        ptr[3] = led_strip_particles_add8(ptr[3], (uint8_t) ((r * next) >> 8));
+        if (power) {
+            led_strip_power_add(power, ptr);
+        }
+    }
+}
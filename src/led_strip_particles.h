@@ -0,0 +1,128 @@
+/*!
+@file led_strip_particles.h
+
+@brief A particle system for comets, sparks and fireworks on a strip. Each
+       property of the particles is kept in its own array, so updating them
+       is a few tight loops the compiler can vectorize. Rendering adds every
+       particle straight into the pixel buffer in a single pass, without the
+       bounds checks and pixel packing of a get and set call per particle.
+
+       Positions and velocities are fixed point with LED_STRIP_PARTICLE_ONE
+       steps per LED, so particles move smoothly between LEDs.
+**/
+
+#ifndef LED_STRIP_PARTICLES_H
+#define LED_STRIP_PARTICLES_H
+
+#include "led_strip.h"
+#include "led_strip_arena.h"
+
+// One LED in particle positions, velocities and gravity.
+#define LED_STRIP_PARTICLE_ONE 256
+
+// Opaque data structure containing the particles.
+typedef struct _led_strip_particles_t led_strip_particles_t;
+
+/*
+@brief The number of bytes a particle system needs, for
+       led_strip_particles_create_arena.
+
+@param capacity The most particles alive at once.
+@return The size in bytes
+*/
+size_t led_strip_particles_required_size(uint32_t capacity);
+
+/*
+@brief Create a particle system in a single block of heap memory.
+
+@param capacity The most particles alive at once.
+@param num_leds The length of the strip. Particles that leave it die.
+@return A pointer to the allocated particle system or NULL on error
+*/
+led_strip_particles_t * led_strip_particles_create(uint32_t capacity, uint32_t num_leds);
+
+/*
+@brief Create a particle system in an arena. Destroy does not free it.
+
+@param arena The arena to take the memory from.
+@param capacity The most particles alive at once.
+@param num_leds The length of the strip. Particles that leave it die.
+@return A pointer to the particle system or NULL if the arena is too small
+*/
+led_strip_particles_t * led_strip_particles_create_arena(led_strip_arena_t * arena,
+                                                         uint32_t capacity,
+                                                         uint32_t num_leds);
+
+/*
+@brief Free all resources of a particle system.
+
+@param particles The particle system object.
+*/
+void led_strip_particles_destroy(led_strip_particles_t * particles);
+
+/*
+@brief Set the forces applied by every update. Starts with no gravity and
+       nothing slowing or fading the particles.
+
+@param particles The particle system object.
+@param gravity Added to every velocity per update, in LED_STRIP_PARTICLE_ONE
+               per update squared. Negative pulls towards pixel 0.
+@param drag The fraction of the velocity kept per update, 255 for all.
+@param fade The fraction of the intensity kept per update, 255 for all.
+*/
+void led_strip_particles_set_forces(led_strip_particles_t * particles,
+                                    int32_t gravity, uint8_t drag, uint8_t fade);
+
+/*
+@brief Add a particle.
+
+@param particles The particle system object.
+@param position Where it starts, in LED_STRIP_PARTICLE_ONE per LED.
+@param velocity How far it moves per update, in LED_STRIP_PARTICLE_ONE per LED.
+@param r  red
+@param g  green
+@param b  blue
+@param life The number of updates before it dies.
+@return 0 on success, -1 if the system is full or the position is off the strip
+*/
+int led_strip_particles_spawn(led_strip_particles_t * particles,
+                              int32_t position, int32_t velocity,
+                              uint8_t r, uint8_t g, uint8_t b,
+                              uint16_t life);
+
+/*
+@brief The number of particles alive.
+
+@param particles The particle system object.
+@return The count
+*/
+uint32_t led_strip_particles_count(led_strip_particles_t * particles);
+
+/*
+@brief Remove every particle.
+
+@param particles The particle system object.
+*/
+void led_strip_particles_clear(led_strip_particles_t * particles);
+
+/*
+@brief Move every particle one step and remove those that died, faded out or
+       left the strip. The order of the particles changes.
+
+@param particles The particle system object.
+*/
+void led_strip_particles_update(led_strip_particles_t * particles);
+
+/*
+@brief Add the color of every particle to the pixels it is on. A particle
+       between two LEDs is split between them. Colors saturate at 255 and
+       brightness is not changed, so clear or fade the strip first for
+       trails. Does not write to the strip.
+
+@param particles The particle system object.
+@param led_strip The led strip object. Particles past its end are not drawn.
+*/
+void led_strip_particles_render(led_strip_particles_t * particles,
+                                led_strip_t * led_strip);
+
+#endif
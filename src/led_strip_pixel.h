@@ -0,0 +1,44 @@
+/*!
+@file led_strip_pixel.h
+
+@brief Helpers for the in-memory pixel format. Each pixel is stored as the four
+       bytes sent to the strip: brightness, blue, green, red. This file should
+       never be included by the user.
+**/
+
+#ifndef LED_STRIP_PIXEL_H
+#define LED_STRIP_PIXEL_H
+
+#include <stdint.h>
+
+#define PIXEL_BRIGHTNESS_MASK 0x1F
+#define PIXEL_BRIGHTNESS_HIGH_BITS 0xE0
+
+/*
+@brief Pack the four bytes of a pixel into the value stored in the buffer.
+       Works with whole pixels independent of the byte order of the CPU.
+*/
+static inline uint32_t led_strip_pixel_pack(uint8_t brightness_byte,
+                                            uint8_t b, uint8_t g, uint8_t r)
+{
+    uint32_t pixel;
+    uint8_t * ptr = (uint8_t*) &pixel;
+    ptr[0] = brightness_byte;
+    ptr[1] = b;
+    ptr[2] = g;
+    ptr[3] = r;
+    return pixel;
+}
+
+/*
+@brief Clamp a brightness to PIXEL_MAX_BRIGHTNESS and add the high bits.
+*/
+static inline uint8_t led_strip_pixel_brightness_byte(uint8_t brightness)
+{
+    if (brightness > PIXEL_BRIGHTNESS_MASK) {
+        brightness = PIXEL_BRIGHTNESS_MASK;
+    }
+    return brightness | PIXEL_BRIGHTNESS_HIGH_BITS;
+}
+
+#endif
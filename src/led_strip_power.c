@@ -0,0 +1,174 @@
+/*!
+@file led_strip_power.c
+
+@brief Implementation of the current estimate and limit.
+**/
+
+#include "led_strip_power_track.h"
+#include "led_strip_struct.h"
+
+#include <stdlib.h> // for malloc
+#include <stddef.h> // for NULL
+
+// Full color times full brightness, the denominator of every channel
+#define POWER_FULL_SCALE (255 * PIXEL_BRIGHTNESS_MASK)
+
+
+static void led_strip_power_refresh(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip->power;
+
+    for (int c = 0; c < 4; c++) {
+        power->sum[c] = 0;
+        power->weighted[c] = 0;
+    }
+    led_strip_power_add_range(power, led_strip->pixels, led_strip->num_leds);
+    power->dirty = 0;
+}
+
+// Current of the colors alone, without the idle current
+static uint64_t led_strip_power_color_ua(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip->power;
+
+    if (power->dirty) {
+        led_strip_power_refresh(led_strip);
+    }
+
+    return (power->weighted[3] * power->model.r_ua +
+            power->weighted[2] * power->model.g_ua +
+            power->weighted[1] * power->model.b_ua) / POWER_FULL_SCALE;
+}
+
+int led_strip_power_enable(led_strip_t * led_strip,
+                           const led_strip_power_model_t * model,
+                           uint32_t budget_ma)
+{
+    // Views count towards the estimate of the strip they are a range of
+    if (led_strip->parent) {
+        return -1;
+    }
+
+    if (led_strip->power) {
+        led_strip_power_disable(led_strip);
+    }
+
+    struct _led_strip_power_t * power = (struct _led_strip_power_t *)
+        malloc(sizeof(struct _led_strip_power_t));
+
+    if (!power) {
+        return -1;
+    }
+
+    power->tx = (uint32_t *) malloc(led_strip->num_leds * sizeof(uint32_t));
+
+    if (!power->tx) {
+        free(power);
+        return -1;
+    }
+
+    if (model) {
+        power->model = *model;
+    } else {
+        power->model.r_ua = LED_STRIP_POWER_DEFAULT_CHANNEL_UA;
+        power->model.g_ua = LED_STRIP_POWER_DEFAULT_CHANNEL_UA;
+        power->model.b_ua = LED_STRIP_POWER_DEFAULT_CHANNEL_UA;
+        power->model.idle_ua = LED_STRIP_POWER_DEFAULT_IDLE_UA;
+    }
+
+    power->owner = led_strip;
+    power->budget_ma = budget_ma;
+    power->scale = LED_STRIP_POWER_SCALE_NONE;
+    led_strip->power = power;
+    led_strip_power_refresh(led_strip);
+
+    return 0;
+}
+
+void led_strip_power_disable(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip->power;
+
+    if (!power) {
+        return;
+    }
+
+    // Send the pixels as they are again
+    if (!led_strip->protocol->encode) {
+        led_strip->tx_data = (uint8_t *) led_strip->pixels;
+    }
+
+    free(power->tx);
+    free(power);
+    led_strip->power = NULL;
+}
+
+void led_strip_power_set_budget(led_strip_t * led_strip, uint32_t budget_ma)
+{
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (power) {
+        power->budget_ma = budget_ma;
+    }
+}
+
+uint32_t led_strip_power_estimate_ma(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (!power) {
+        return 0;
+    }
+
+    uint64_t idle_ua = (uint64_t) power->owner->num_leds * power->model.idle_ua;
+
+    return (uint32_t) ((idle_ua + led_strip_power_color_ua(power->owner)) / 1000);
+}
+
+uint16_t led_strip_power_get_scale(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    return power ? power->scale : LED_STRIP_POWER_SCALE_NONE;
+}
+
+uint16_t led_strip_power_limit(led_strip_t * led_strip)
+{
+    struct _led_strip_power_t * power = led_strip->power;
+    uint32_t num_leds = led_strip->num_leds;
+
+    power->scale = LED_STRIP_POWER_SCALE_NONE;
+
+    if (power->budget_ma) {
+        uint64_t budget_ua = (uint64_t) power->budget_ma * 1000;
+        uint64_t idle_ua = (uint64_t) num_leds * power->model.idle_ua;
+        uint64_t color_ua = led_strip_power_color_ua(led_strip);
+
+        // A dark strip over the budget draws only idle current, which no
+        // scale can lower
+        if (color_ua != 0 && idle_ua + color_ua > budget_ua) {
+            // Only the colors can be turned down
+            uint64_t available_ua = (budget_ua > idle_ua) ? budget_ua - idle_ua : 0;
+            power->scale = (uint16_t) ((available_ua * LED_STRIP_POWER_SCALE_NONE) / color_ua);
+        }
+    }
+
+    return power->scale;
+}
+
+const uint32_t * led_strip_power_apply(led_strip_t * led_strip, uint16_t scale)
+{
+    struct _led_strip_power_t * power = led_strip->power;
+    uint32_t num_leds = led_strip->num_leds;
+    const uint8_t * in = (const uint8_t *) led_strip->pixels;
+    uint8_t * out = (uint8_t *) power->tx;
+
+    for (uint32_t i = 0; i < num_leds; i++) {
+        out[4*i + 0] = in[4*i + 0];
+        out[4*i + 1] = (uint8_t) ((in[4*i + 1] * scale) >> 8);
+        out[4*i + 2] = (uint8_t) ((in[4*i + 2] * scale) >> 8);
+        out[4*i + 3] = (uint8_t) ((in[4*i + 3] * scale) >> 8);
+    }
+
+    return power->tx;
+}
@@ -0,0 +1,79 @@
+/*!
+@file led_strip_power.h
+
+@brief Estimate the current drawn by a strip and keep it under a budget.
+       The estimate is kept up to date as pixels are set, so reading it
+       costs the same for any number of LEDs. When a budget is set and the
+       estimate is over it, show sends every color scaled down by the same
+       factor while the pixels themselves stay as they were set. The scale
+       goes into the calibration tables or the encoder of the chip, and only
+       chips sent straight from the pixels need a scaled copy of them.
+**/
+
+#ifndef LED_STRIP_POWER_H
+#define LED_STRIP_POWER_H
+
+#include "led_strip.h"
+
+// Typical draw of one APA102 channel at full color and brightness.
+#define LED_STRIP_POWER_DEFAULT_CHANNEL_UA 20000
+
+// Typical draw of one dark APA102.
+#define LED_STRIP_POWER_DEFAULT_IDLE_UA 1000
+
+// Scale that sends the colors unchanged.
+#define LED_STRIP_POWER_SCALE_NONE 256
+
+typedef struct led_strip_power_model_t {
+    uint32_t r_ua;    // Red channel at full color and brightness, in microamps
+    uint32_t g_ua;    // Green channel at full color and brightness, in microamps
+    uint32_t b_ua;    // Blue channel at full color and brightness, in microamps
+    uint32_t idle_ua; // One LED with every channel off, in microamps
+} led_strip_power_model_t;
+
+/*
+@brief Start estimating the current of a strip. Reads every pixel once.
+       Changes made through views of the strip are counted too, also for
+       views created before.
+
+@param led_strip The led strip object, not a view.
+@param model The current of each channel, or NULL for the defaults.
+@param budget_ma The most current show may draw in milliamps, or 0 for no limit.
+@return 0 on success, -1 for a view or on allocation error
+*/
+int led_strip_power_enable(led_strip_t * led_strip,
+                           const led_strip_power_model_t * model,
+                           uint32_t budget_ma);
+
+/*
+@brief Stop estimating and limiting current. Destroy does this too.
+
+@param led_strip The led strip object.
+*/
+void led_strip_power_disable(led_strip_t * led_strip);
+
+/*
+@brief Change the current budget.
+
+@param led_strip The led strip object.
+@param budget_ma The most current show may draw in milliamps, or 0 for no limit.
+*/
+void led_strip_power_set_budget(led_strip_t * led_strip, uint32_t budget_ma);
+
+/*
+@brief The current the pixels would draw as they are set, before limiting.
+
+@param led_strip The led strip object.
+@return The estimate in milliamps, or 0 if estimating is not enabled
+*/
+uint32_t led_strip_power_estimate_ma(led_strip_t * led_strip);
+
+/*
+@brief The scale that show applied to the colors last time.
+
+@param led_strip The led strip object.
+@return From 0 to LED_STRIP_POWER_SCALE_NONE
+*/
+uint16_t led_strip_power_get_scale(led_strip_t * led_strip);
+
+#endif
@@ -0,0 +1,104 @@
+/*!
+@file led_strip_power_track.h
+
+@brief Running sums behind the current estimate and the helpers that keep
+       them up to date as pixels change. This file should never be included
+       by the user.
+**/
+
+#ifndef LED_STRIP_POWER_TRACK_H
+#define LED_STRIP_POWER_TRACK_H
+
+#include "led_strip_power.h"
+#include "led_strip_pixel.h"
+#include "led_strip_struct.h"
+
+struct _led_strip_power_t {
+    led_strip_t * owner;   // The strip the sums are over, views share them
+    uint64_t sum[4];       // Per pixel byte: brightness, blue, green, red
+    uint64_t weighted[4];  // Colors times brightness, the first is unused
+    int dirty;             // The sums must be recomputed from the pixels
+    led_strip_power_model_t model;
+    uint32_t budget_ma;
+    uint16_t scale;        // Applied by the last show
+    uint32_t * tx;         // Scaled pixels while limiting
+};
+
+/*
+@brief The estimate that changes to a strip count towards. A view has none of
+       its own and uses the one of the strip it is a range of, looked up here
+       on every use so enabling or disabling it on that strip is always seen.
+*/
+static inline struct _led_strip_power_t * led_strip_power_of(const led_strip_t * led_strip)
+{
+    while (led_strip->parent) {
+        led_strip = led_strip->parent;
+    }
+    return led_strip->power;
+}
+
+static inline void led_strip_power_add(struct _led_strip_power_t * power,
+                                       const uint8_t * ptr)
+{
+    uint32_t brightness = ptr[0] & PIXEL_BRIGHTNESS_MASK;
+
+    power->sum[0] += brightness;
+    for (int c = 1; c < 4; c++) {
+        power->sum[c] += ptr[c];
+        power->weighted[c] += ptr[c] * brightness;
+    }
+}
+
+static inline void led_strip_power_remove(struct _led_strip_power_t * power,
+                                          const uint8_t * ptr)
+{
+    uint32_t brightness = ptr[0] & PIXEL_BRIGHTNESS_MASK;
+
+    power->sum[0] -= brightness;
+    for (int c = 1; c < 4; c++) {
+        power->sum[c] -= ptr[c];
+        power->weighted[c] -= ptr[c] * brightness;
+    }
+}
+
+static inline void led_strip_power_add_range(struct _led_strip_power_t * power,
+                                             const uint32_t * pixels, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        led_strip_power_add(power, (const uint8_t *) &pixels[i]);
+    }
+}
+
+static inline void led_strip_power_remove_range(struct _led_strip_power_t * power,
+                                                const uint32_t * pixels, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        led_strip_power_remove(power, (const uint8_t *) &pixels[i]);
+    }
+}
+
+/*
+@brief Record that pixels were written in a way the sums can't follow, e.g.
+       by a whole buffer copy. The sums are recomputed when next needed.
+*/
+static inline void led_strip_power_invalidate(struct _led_strip_power_t * power)
+{
+    if (power) {
+        power->dirty = 1;
+    }
+}
+
+/*
+@brief The scale that keeps the colors of a strip within its budget, from the
+       estimate alone. Called by led_strip_show, which folds the scale into
+       the next pass over the pixels.
+*/
+uint16_t led_strip_power_limit(led_strip_t * led_strip);
+
+/*
+@brief Scale a copy of the pixels of a strip. Only for when show has no other
+       pass over the pixels to fold the scale into.
+*/
+const uint32_t * led_strip_power_apply(led_strip_t * led_strip, uint16_t scale);
+
+#endif
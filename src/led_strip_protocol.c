@@ -0,0 +1,92 @@
+/*!
+@file led_strip_protocol.c
+
+@brief Frame lengths and pixel encoders for each supported LED chip.
+**/
+
+#include "led_strip_protocol.h"
+#include "led_strip_pixel.h"
+
+#include <stddef.h> // for NULL
+
+
+static uint32_t led_strip_footer_len_apa102(uint32_t num_leds)
+{
+    return LED_STRIP_APA102_FOOTER_LENGTH(num_leds);
+}
+
+static uint32_t led_strip_footer_len_sk9822(uint32_t num_leds)
+{
+    return LED_STRIP_SK9822_FOOTER_LENGTH(num_leds);
+}
+
+static uint32_t led_strip_footer_len_hd107s(uint32_t num_leds)
+{
+    return LED_STRIP_HD107S_FOOTER_LENGTH(num_leds);
+}
+
+static uint32_t led_strip_footer_len_ws2801(uint32_t num_leds)
+{
+    (void) num_leds;
+    return LED_STRIP_WS2801_FOOTER_LENGTH(num_leds);
+}
+
+// WS2801 has no global brightness, so it is applied to the colors as
+// RGB bytes are written, together with the scale of the power limit.
+static void led_strip_encode_ws2801(const uint32_t * pixels, uint8_t * out, uint32_t num_leds,
+                                    uint16_t limit)
+{
+    for (uint32_t i = 0; i < num_leds; i++) {
+        const uint8_t * ptr = (const uint8_t *) &pixels[i];
+        // Expand the 5 bit brightness to 1..256 so max brightness is exact.
+        // Both can be 256, which overflows a 16 bit int.
+        uint16_t brightness = ptr[0] & PIXEL_BRIGHTNESS_MASK;
+        uint16_t scale = (uint16_t) (((uint32_t) (((brightness << 3) | (brightness >> 2)) + 1) *
+                                      limit) >> 8);
+
+        out[0] = (uint8_t) ((ptr[3] * scale) >> 8);
+        out[1] = (uint8_t) ((ptr[2] * scale) >> 8);
+        out[2] = (uint8_t) ((ptr[1] * scale) >> 8);
+        out += 3;
+    }
+}
+
+const led_strip_protocol_t led_strip_protocol_apa102 = {
+    "APA102",
+    LED_STRIP_APA102_HEADER_LENGTH,
+    &led_strip_footer_len_apa102,
+    LED_STRIP_APA102_FOOTER_BYTE,
+    4,
+    LED_STRIP_APA102_MAX_FREQUENCY,
+    NULL
+};
+
+const led_strip_protocol_t led_strip_protocol_sk9822 = {
+    "SK9822",
+    LED_STRIP_SK9822_HEADER_LENGTH,
+    &led_strip_footer_len_sk9822,
+    LED_STRIP_SK9822_FOOTER_BYTE,
+    4,
+    LED_STRIP_SK9822_MAX_FREQUENCY,
+    NULL
+};
+
+const led_strip_protocol_t led_strip_protocol_hd107s = {
+    "HD107S",
+    LED_STRIP_HD107S_HEADER_LENGTH,
+    &led_strip_footer_len_hd107s,
+    LED_STRIP_HD107S_FOOTER_BYTE,
+    4,
+    LED_STRIP_HD107S_MAX_FREQUENCY,
+    NULL
+};
+
+const led_strip_protocol_t led_strip_protocol_ws2801 = {
+    "WS2801",
+    LED_STRIP_WS2801_HEADER_LENGTH,
+    &led_strip_footer_len_ws2801,
+    LED_STRIP_WS2801_FOOTER_BYTE,
+    3,
+    LED_STRIP_WS2801_MAX_FREQUENCY,
+    &led_strip_encode_ws2801
+};
@@ -0,0 +1,61 @@
+/*!
+@file led_strip_protocol.h
+
+@brief Wire encodings of the supported LED chips. A protocol describes the
+       start frame, the end frame and how pixels are sent. Pass one of the
+       protocols below to the _protocol variant of a create function.
+**/
+
+#ifndef LED_STRIP_PROTOCOL_H
+#define LED_STRIP_PROTOCOL_H
+
+#include <stdint.h>
+
+/*
+ * Frame sizes in bytes. The end frame only has to provide num_leds/2 extra
+ * clock edges so the data reaches the last LED, and SK9822 also needs a
+ * 32 bit reset frame before it to latch the new brightness.
+ */
+#define LED_STRIP_APA102_HEADER_LENGTH 4
+#define LED_STRIP_APA102_FOOTER_LENGTH(num_leds) (((num_leds) + 15)/16)
+#define LED_STRIP_APA102_FOOTER_BYTE 0xFF
+#define LED_STRIP_APA102_MAX_FREQUENCY 20000000
+
+#define LED_STRIP_SK9822_HEADER_LENGTH 4
+#define LED_STRIP_SK9822_FOOTER_LENGTH(num_leds) (4 + ((num_leds) + 15)/16)
+#define LED_STRIP_SK9822_FOOTER_BYTE 0x00
+#define LED_STRIP_SK9822_MAX_FREQUENCY 20000000
+
+#define LED_STRIP_HD107S_HEADER_LENGTH 4
+#define LED_STRIP_HD107S_FOOTER_LENGTH(num_leds) (((num_leds) + 15)/16)
+#define LED_STRIP_HD107S_FOOTER_BYTE 0xFF
+#define LED_STRIP_HD107S_MAX_FREQUENCY 40000000
+
+// WS2801 latches after the clock is held low for 500 us, so there are no frames.
+#define LED_STRIP_WS2801_HEADER_LENGTH 0
+#define LED_STRIP_WS2801_FOOTER_LENGTH(num_leds) 0
+#define LED_STRIP_WS2801_FOOTER_BYTE 0x00
+#define LED_STRIP_WS2801_MAX_FREQUENCY 25000000
+
+typedef struct led_strip_protocol_t {
+    const char * name;
+    uint32_t header_len;     // Start frame length, all zeros
+    uint32_t (*footer_len)(uint32_t num_leds); // End frame length
+    uint8_t footer_byte;     // Value of every end frame byte
+    uint32_t bytes_per_pixel;
+    uint32_t max_frequency;  // Highest recommended SPI frequency in Hz
+    /*
+    Convert the pixels to the bytes sent on the wire, with every color
+    scaled by scale/256. NULL if the pixels are already stored in wire format
+    and can be sent without a copy.
+    */
+    void (*encode)(const uint32_t * pixels, uint8_t * out, uint32_t num_leds,
+                   uint16_t scale);
+} led_strip_protocol_t;
+
+extern const led_strip_protocol_t led_strip_protocol_apa102;
+extern const led_strip_protocol_t led_strip_protocol_sk9822;
+extern const led_strip_protocol_t led_strip_protocol_hd107s;
+extern const led_strip_protocol_t led_strip_protocol_ws2801;
+
+#endif
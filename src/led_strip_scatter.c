@@ -0,0 +1,127 @@
+/*!
+@file led_strip_scatter.c
+
+@brief Implementation of scattered pixel updates.
+**/
+
+#include "led_strip_scatter.h"
+#include "led_strip_struct.h"
+#include "led_strip_pixel.h"
+#include "led_strip_power_track.h"
+
+#include <string.h> // for memset
+
+// Stable radix sort by index, one byte of the index per pass. Only the bytes
+// below max_index are sorted. Returns the array the sorted updates are in.
+static led_strip_update_t * led_strip_scatter_sort(led_strip_update_t * updates,
+                                                   led_strip_update_t * scratch,
+                                                   uint32_t count,
+                                                   uint32_t max_index)
+{
+    uint32_t offsets[256];
+
+    for (uint32_t shift = 0; shift < 32 && (max_index >> shift) != 0; shift += 8) {
+        memset(offsets, 0, sizeof(offsets));
+        for (uint32_t i = 0; i < count; i++) {
+            offsets[(updates[i].p >> shift) & 0xFF]++;
+        }
+
+        uint32_t sum = 0;
+        for (uint32_t digit = 0; digit < 256; digit++) {
+            uint32_t n = offsets[digit];
+            offsets[digit] = sum;
+            sum += n;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            scratch[offsets[(updates[i].p >> shift) & 0xFF]++] = updates[i];
+        }
+
+        led_strip_update_t * sorted = scratch;
+        scratch = updates;
+        updates = sorted;
+    }
+
+    return updates;
+}
+
+int led_strip_scatter(led_strip_t * led_strip,
+                      led_strip_update_t * updates,
+                      uint32_t count,
+                      led_strip_update_t * scratch,
+                      led_strip_scatter_changes_t * changes)
+{
+    uint32_t num_leds = led_strip->num_leds;
+    struct _led_strip_power_t * power = led_strip_power_of(led_strip);
+
+    if (changes) {
+        memset(changes, 0, sizeof(led_strip_scatter_changes_t));
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // Check every index at once, so the loops below need no checks
+    uint32_t max_index = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        max_index = (updates[i].p > max_index) ? updates[i].p : max_index;
+    }
+    if (max_index >= num_leds) {
+        return -1;
+    }
+
+    if (scratch) {
+        updates = led_strip_scatter_sort(updates, scratch, count, max_index);
+    }
+
+    // Reversed strips store pixel p at num_leds - 1 - p, which is ~p + num_leds
+    uint32_t mirror = led_strip->reversed ? 0xFFFFFFFFu : 0;
+    uint32_t base = mirror & num_leds;
+    uint32_t * pixels = led_strip->pixels;
+
+    if (power || changes) {
+        uint32_t changed = 0;
+        uint32_t first = num_leds;
+        uint32_t last = 0;
+
+        // Only pixels that get a new value need their power recounted
+        for (uint32_t i = 0; i < count; i++) {
+            const led_strip_update_t * update = &updates[i];
+            uint32_t * pixel = &pixels[(update->p ^ mirror) + base];
+            uint32_t value =
+                led_strip_pixel_pack(led_strip_pixel_brightness_byte(update->brightness),
+                                     update->b, update->g, update->r);
+
+            if (*pixel == value) {
+                continue;
+            }
+            if (power) {
+                led_strip_power_remove(power, (const uint8_t *) pixel);
+                *pixel = value;
+                led_strip_power_add(power, (const uint8_t *) pixel);
+            } else {
+                *pixel = value;
+            }
+
+            changed++;
+            first = (update->p < first) ? update->p : first;
+            last = (update->p > last) ? update->p : last;
+        }
+
+        if (changes && changed) {
+            changes->count = changed;
+            changes->first = first;
+            changes->end = last + 1;
+        }
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            const led_strip_update_t * update = &updates[i];
+
+            pixels[(update->p ^ mirror) + base] =
+                led_strip_pixel_pack(led_strip_pixel_brightness_byte(update->brightness),
+                                     update->b, update->g, update->r);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*!
+@file led_strip_scatter.h
+
+@brief Set many unrelated pixels with one call, e.g. the pixels that changed
+       since the last frame of a sensor driven wall. The indices are checked
+       once for the whole array instead of once per pixel, and the updates
+       can be sorted first so the pixels are written in memory order.
+**/
+
+#ifndef LED_STRIP_SCATTER_H
+#define LED_STRIP_SCATTER_H
+
+#include "led_strip.h"
+
+typedef struct led_strip_update_t {
+    uint32_t p;         // The pixel index, starting at 0
+    uint8_t r;          // red
+    uint8_t g;          // green
+    uint8_t b;          // blue
+    uint8_t brightness; // Up to PIXEL_MAX_BRIGHTNESS
+} led_strip_update_t;
+
+// The pixels a scatter call changed, for consumers that only want to look at
+// those, e.g. to send or record part of a frame
+typedef struct led_strip_scatter_changes_t {
+    uint32_t count; // Updates that changed the color or brightness of their pixel
+    uint32_t first; // The lowest changed index
+    uint32_t end;   // One past the highest changed index, 0 if none changed
+} led_strip_scatter_changes_t;
+
+/*
+@brief Set the color and brightness of a list of pixels, as if
+       led_strip_set_pixel_color_and_brightness was called for each in order.
+       When a pixel is in the list more than once the last update wins, also
+       when sorting. Just modifies the buffer and does not write to the strip.
+
+@param led_strip The led strip object.
+@param updates The pixels to set.
+@param count The number of updates.
+@param scratch NULL to write the pixels in the order given, or room for count
+               updates to sort them by index first. Sorting overwrites both
+               updates and scratch. It costs more than it saves where random
+               writes are cheap, as on a PC, so measure before using it,
+               e.g. for strips in slow external RAM.
+@param changes Set to the pixels that changed, by the same indices as the
+               updates. Updates that write the color a pixel already has are
+               not counted. May be NULL.
+@return -1 if any index is past the end of the strip, in which case no pixel
+        is changed
+*/
+int led_strip_scatter(led_strip_t * led_strip,
+                      led_strip_update_t * updates,
+                      uint32_t count,
+                      led_strip_update_t * scratch,
+                      led_strip_scatter_changes_t * changes);
+
+#endif
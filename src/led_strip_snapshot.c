@@ -0,0 +1,188 @@
+/*!
+@file led_strip_snapshot.c
+
+@brief Implementation of copy-on-write snapshots of the led strip.
+**/
+
+#include "led_strip_snapshot.h"
+#include "led_strip_struct.h"
+#include "led_strip_power_track.h"
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy, memcmp
+#include <stddef.h> // for NULL
+
+typedef struct led_strip_snapshot_chunk_t {
+    uint32_t ref_count; // Number of snapshots using this chunk
+    uint32_t pixels[LED_STRIP_SNAPSHOT_CHUNK_PIXELS];
+} led_strip_snapshot_chunk_t;
+
+struct _led_strip_snapshot_t {
+    uint32_t num_leds;
+    uint32_t num_chunks;
+    led_strip_snapshot_chunk_t ** chunks;
+};
+
+
+static led_strip_snapshot_t * led_strip_snapshot_allocate(uint32_t num_leds)
+{
+    uint32_t num_chunks = (num_leds + LED_STRIP_SNAPSHOT_CHUNK_PIXELS - 1) /
+                          LED_STRIP_SNAPSHOT_CHUNK_PIXELS;
+
+    // The chunk table is stored right after the snapshot
+    led_strip_snapshot_t * snapshot = (led_strip_snapshot_t *)
+        malloc(sizeof(led_strip_snapshot_t) +
+               num_chunks * sizeof(led_strip_snapshot_chunk_t *));
+
+    if (snapshot) {
+        snapshot->num_leds = num_leds;
+        snapshot->num_chunks = num_chunks;
+        snapshot->chunks = (led_strip_snapshot_chunk_t **) (snapshot + 1);
+    }
+
+    return snapshot;
+}
+
+static uint32_t led_strip_snapshot_chunk_bytes(uint32_t num_leds, uint32_t chunk)
+{
+    uint32_t remaining = num_leds - chunk * LED_STRIP_SNAPSHOT_CHUNK_PIXELS;
+
+    if (remaining > LED_STRIP_SNAPSHOT_CHUNK_PIXELS) {
+        remaining = LED_STRIP_SNAPSHOT_CHUNK_PIXELS;
+    }
+
+    return remaining * sizeof(uint32_t);
+}
+
+// The pixels of a chunk from pixel 0 of the strip on. A reversed strip stores
+// them back to front, so they are gathered into buffer.
+static const uint32_t * led_strip_snapshot_read_chunk(const led_strip_t * led_strip,
+                                                      uint32_t chunk, uint32_t * buffer)
+{
+    uint32_t first = chunk * LED_STRIP_SNAPSHOT_CHUNK_PIXELS;
+
+    if (!led_strip->reversed) {
+        return &led_strip->pixels[first];
+    }
+
+    uint32_t count = led_strip_snapshot_chunk_bytes(led_strip->num_leds, chunk) /
+                     sizeof(uint32_t);
+    const uint32_t * stored = &led_strip->pixels[led_strip->num_leds - 1 - first];
+    for (uint32_t i = 0; i < count; i++) {
+        buffer[i] = *(stored - i);
+    }
+
+    return buffer;
+}
+
+// Create a new snapshot that shares all chunks of the given snapshot.
+static led_strip_snapshot_t * led_strip_snapshot_share(const led_strip_snapshot_t * snapshot)
+{
+    led_strip_snapshot_t * shared = led_strip_snapshot_allocate(snapshot->num_leds);
+
+    if (shared) {
+        for (uint32_t i = 0; i < snapshot->num_chunks; i++) {
+            shared->chunks[i] = snapshot->chunks[i];
+            shared->chunks[i]->ref_count++;
+        }
+    }
+
+    return shared;
+}
+
+led_strip_snapshot_t * led_strip_snapshot_save(led_strip_t * led_strip)
+{
+    // The strip keeps its own reference to the chunks of the last saved state
+    // so the next save can share everything that has not changed since.
+    led_strip_snapshot_t * previous = led_strip->snapshot_cache;
+    led_strip_snapshot_t * snapshot = led_strip_snapshot_allocate(led_strip->num_leds);
+    led_strip_snapshot_t * cache = led_strip_snapshot_allocate(led_strip->num_leds);
+
+    if (!snapshot || !cache) {
+        free(snapshot);
+        free(cache);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < snapshot->num_chunks; i++) {
+        uint32_t buffer[LED_STRIP_SNAPSHOT_CHUNK_PIXELS];
+        const uint32_t * pixels = led_strip_snapshot_read_chunk(led_strip, i, buffer);
+        uint32_t bytes = led_strip_snapshot_chunk_bytes(led_strip->num_leds, i);
+        led_strip_snapshot_chunk_t * chunk;
+
+        if (previous && memcmp(previous->chunks[i]->pixels, pixels, bytes) == 0) {
+            chunk = previous->chunks[i];
+        } else {
+            chunk = (led_strip_snapshot_chunk_t *) malloc(sizeof(led_strip_snapshot_chunk_t));
+
+            if (!chunk) {
+                // Only release the chunks that were already referenced
+                snapshot->num_chunks = i;
+                cache->num_chunks = i;
+                led_strip_snapshot_destroy(snapshot);
+                led_strip_snapshot_destroy(cache);
+                return NULL;
+            }
+
+            chunk->ref_count = 0;
+            memcpy(chunk->pixels, pixels, bytes);
+        }
+
+        // Referenced by both the snapshot and the cache
+        chunk->ref_count += 2;
+        snapshot->chunks[i] = chunk;
+        cache->chunks[i] = chunk;
+    }
+
+    if (previous) {
+        led_strip_snapshot_destroy(previous);
+    }
+    led_strip->snapshot_cache = cache;
+
+    return snapshot;
+}
+
+int led_strip_snapshot_restore(led_strip_t * led_strip,
+                               const led_strip_snapshot_t * snapshot)
+{
+    if (snapshot->num_leds != led_strip->num_leds) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < snapshot->num_chunks; i++) {
+        uint32_t first = i * LED_STRIP_SNAPSHOT_CHUNK_PIXELS;
+        uint32_t bytes = led_strip_snapshot_chunk_bytes(snapshot->num_leds, i);
+
+        if (!led_strip->reversed) {
+            memcpy(&led_strip->pixels[first], snapshot->chunks[i]->pixels, bytes);
+            continue;
+        }
+
+        uint32_t * stored = &led_strip->pixels[led_strip->num_leds - 1 - first];
+        for (uint32_t p = 0; p < bytes / sizeof(uint32_t); p++) {
+            *(stored - p) = snapshot->chunks[i]->pixels[p];
+        }
+    }
+
+    led_strip_power_invalidate(led_strip_power_of(led_strip));
+
+    // The strip now matches the snapshot, so the next save can share all of it.
+    // If this allocation fails the next save simply copies every chunk.
+    if (led_strip->snapshot_cache) {
+        led_strip_snapshot_destroy(led_strip->snapshot_cache);
+    }
+    led_strip->snapshot_cache = led_strip_snapshot_share(snapshot);
+
+    return 0;
+}
+
+void led_strip_snapshot_destroy(led_strip_snapshot_t * snapshot)
+{
+    for (uint32_t i = 0; i < snapshot->num_chunks; i++) {
+        if (--snapshot->chunks[i]->ref_count == 0) {
+            free(snapshot->chunks[i]);
+        }
+    }
+
+    free(snapshot);
+}
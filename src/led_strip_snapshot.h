@@ -0,0 +1,53 @@
+/*!
+@file led_strip_snapshot.h
+
+@brief Save and restore the contents of a led strip. A snapshot is split into
+       chunks of pixels. Chunks that did not change since the previous save of
+       the same strip are shared, so many saved states of a large strip only
+       cost memory for the regions where they differ.
+
+       Pixels are saved by their index, so a snapshot of a reversed view
+       restored to a strip that is not reversed reads the same from pixel 0
+       on, rather than mirrored.
+**/
+
+#ifndef LED_STRIP_SNAPSHOT_H
+#define LED_STRIP_SNAPSHOT_H
+
+#include "led_strip.h"
+
+// Number of pixels stored in each shared chunk of a snapshot.
+#define LED_STRIP_SNAPSHOT_CHUNK_PIXELS 64
+
+// Opaque data structure containing a saved state of a led strip.
+typedef struct _led_strip_snapshot_t led_strip_snapshot_t;
+
+/*
+@brief Save the current color and brightness of every pixel in the strip.
+       Only chunks that differ from the last saved or restored state are copied.
+
+@param led_strip The led strip object.
+@return A pointer to the snapshot or NULL on allocation error
+*/
+led_strip_snapshot_t * led_strip_snapshot_save(led_strip_t * led_strip);
+
+/*
+@brief Restore a saved state into the strip with block copies. Does not write
+       to the strip, call led_strip_show to display it.
+
+@param led_strip The led strip object.
+@param snapshot A snapshot saved from a strip with the same number of LEDs.
+@return -1 on error
+*/
+int led_strip_snapshot_restore(led_strip_t * led_strip,
+                               const led_strip_snapshot_t * snapshot);
+
+/*
+@brief Destroy a snapshot. Chunks shared with other snapshots are kept
+       until the last snapshot using them is destroyed.
+
+@param snapshot The snapshot object.
+*/
+void led_strip_snapshot_destroy(led_strip_snapshot_t * snapshot);
+
+#endif
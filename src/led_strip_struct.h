@@ -7,17 +7,30 @@
 #ifndef LED_STRIP_STRUCT_H
 #define LED_STRIP_STRUCT_H
 
-#define HEADER_LENGTH_IN_BYTES 4
+#include "led_strip.h"
+#include "led_strip_protocol.h"
 
 struct _led_strip_t {
     uint32_t *pixels;
     uint32_t num_leds;
+    uint8_t reversed; // Pixel p is stored at num_leds - 1 - p
+    uint8_t owns_memory; // Allocated as one heap block, freed by destroy
+    const led_strip_protocol_t * protocol;
     uint8_t * header_data;
+    uint32_t header_len;
+    uint8_t * tx_data; // Pixels in wire format, same as pixels if no encoding
+    uint32_t tx_len;
     uint8_t * footer_data;
     uint32_t footer_len;
     int (*show) (led_strip_t *);
     void (*destroy) (led_strip_t *);
     void * backend_data; // Backend dependent data
+    led_strip_t * parent; // The strip a view is a range of, NULL if not a view
+    struct _led_strip_snapshot_t * snapshot_cache; // Last saved or restored state
+    struct _led_strip_power_t * power; // Current estimate, NULL if not enabled
+    struct _led_strip_calibration_t * calibration; // Color tables, NULL if not set
+    led_strip_show_hook_t show_hook; // Sees every frame shown, NULL if not set
+    void * show_hook_arg;
 };
 
 #endif
@@ -0,0 +1,86 @@
+/*!
+@file led_strip_view.c
+
+@brief Implementation of segment views.
+**/
+
+#include "led_strip_view.h"
+#include "led_strip_struct.h"
+
+#include <stdlib.h> // for malloc
+#include <stddef.h> // for NULL
+
+static uint32_t led_strip_view_footer_len(uint32_t num_leds)
+{
+    (void) num_leds;
+    return 0;
+}
+
+// Views have no wire format of their own. Their parent encodes on show.
+static const led_strip_protocol_t led_strip_protocol_view = {
+    "view",
+    0,
+    &led_strip_view_footer_len,
+    0,
+    4,
+    0,
+    NULL
+};
+
+static int led_strip_view_show(led_strip_t * led_strip)
+{
+    return led_strip_show((led_strip_t *) led_strip->backend_data);
+}
+
+static void led_strip_view_destroy(led_strip_t * led_strip)
+{
+    // The buffers belong to the parent
+    (void) led_strip;
+}
+
+led_strip_t * led_strip_view_create(led_strip_t * parent,
+                                    uint32_t offset,
+                                    uint32_t length,
+                                    int reversed)
+{
+    if (length == 0 || offset >= parent->num_leds || length > parent->num_leds - offset) {
+        return NULL;
+    }
+
+    led_strip_t * led_strip = (led_strip_t *) malloc(sizeof(led_strip_t));
+
+    if (!led_strip) {
+        return NULL;
+    }
+
+    // A range of a reversed parent is stored mirrored in its pixels
+    if (parent->reversed) {
+        offset = parent->num_leds - offset - length;
+    }
+
+    led_strip->pixels = parent->pixels + offset;
+    led_strip->num_leds = length;
+    led_strip->reversed = (uint8_t) ((reversed != 0) != (parent->reversed != 0));
+    led_strip->owns_memory = 1;
+    led_strip->protocol = &led_strip_protocol_view;
+    led_strip->header_data = NULL;
+    led_strip->header_len = 0;
+    led_strip->tx_data = (uint8_t *) led_strip->pixels;
+    led_strip->tx_len = 0;
+    led_strip->footer_data = NULL;
+    led_strip->footer_len = 0;
+    led_strip->show = &led_strip_view_show;
+    led_strip->destroy = &led_strip_view_destroy;
+    led_strip->backend_data = parent;
+    led_strip->parent = parent;
+    led_strip->snapshot_cache = NULL;
+
+    // Changes through the view count towards the estimate of the parent,
+    // which is looked up through parent on every use
+    led_strip->power = NULL;
+    led_strip->calibration = NULL;
+    led_strip->show_hook = NULL;
+    led_strip->show_hook_arg = NULL;
+
+    return led_strip;
+}
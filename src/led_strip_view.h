@@ -0,0 +1,33 @@
+/*!
+@file led_strip_view.h
+
+@brief Split one led strip into independent segments. A view is a led strip
+       whose pixels are a range of the pixels of its parent, optionally in
+       reverse order, so every function in led_strip.h works on the segment
+       alone. Nothing is copied, and showing a view shows the whole parent in
+       one transfer.
+**/
+
+#ifndef LED_STRIP_VIEW_H
+#define LED_STRIP_VIEW_H
+
+#include "led_strip.h"
+
+/*
+@brief Create a view of a range of pixels of a strip. The parent must outlive
+       the view. Destroy the view with led_strip_destroy, which leaves the
+       pixels of the parent alone.
+
+@param parent The led strip object, which may itself be a view.
+@param offset The first pixel of the parent in the view.
+@param length The number of pixels in the view, at least 1.
+@param reversed Non-zero if pixel 0 of the view is the last pixel of the range.
+@return A pointer to the allocated view or NULL if the range does not fit in
+        the parent or on allocation error
+*/
+led_strip_t * led_strip_view_create(led_strip_t * parent,
+                                    uint32_t offset,
+                                    uint32_t length,
+                                    int reversed);
+
+#endif
@@ -0,0 +1,100 @@
+/*!
+@file led_strip_test.h
+
+@brief Checks and strip helpers shared by the tests. Each test is a program
+       that returns non-zero if any check failed.
+**/
+
+#ifndef LED_STRIP_TEST_H
+#define LED_STRIP_TEST_H
+
+#include "led_strip_no_backend.h"
+#include "led_strip_struct.h"
+
+#include <stdio.h>  // for fprintf
+#include <string.h> // for memcpy
+
+static int led_strip_test_failures = 0;
+
+#define CHECK(condition)                                                  \
+    do {                                                                  \
+        if (!(condition)) {                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                  \
+                    __FILE__, __LINE__, #condition);                      \
+            led_strip_test_failures++;                                    \
+        }                                                                 \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected)                                     \
+    do {                                                                  \
+        long long _actual = (long long) (actual);                         \
+        long long _expected = (long long) (expected);                     \
+        if (_actual != _expected) {                                       \
+            fprintf(stderr, "%s:%d: check failed: %s is %lld, not %lld\n",\
+                    __FILE__, __LINE__, #actual, _actual, _expected);     \
+            led_strip_test_failures++;                                    \
+        }                                                                 \
+    } while (0)
+
+// The bytes the last show of a test strip would have sent
+static uint8_t led_strip_test_wire[4096];
+static uint32_t led_strip_test_wire_len = 0;
+static uint32_t led_strip_test_shows = 0;
+
+static int led_strip_test_show(led_strip_t * led_strip)
+{
+    uint32_t len = led_strip->header_len + led_strip->tx_len + led_strip->footer_len;
+
+    led_strip_test_shows++;
+    led_strip_test_wire_len = 0;
+    if (len > sizeof(led_strip_test_wire)) {
+        return -1;
+    }
+
+    // Some chips have no start or end frame, and no buffer for them
+    if (led_strip->header_len) {
+        memcpy(led_strip_test_wire, led_strip->header_data, led_strip->header_len);
+    }
+    memcpy(led_strip_test_wire + led_strip->header_len, led_strip->tx_data, led_strip->tx_len);
+    if (led_strip->footer_len) {
+        memcpy(led_strip_test_wire + led_strip->header_len + led_strip->tx_len,
+               led_strip->footer_data, led_strip->footer_len);
+    }
+    led_strip_test_wire_len = len;
+
+    return 0;
+}
+
+static void led_strip_test_destroy(led_strip_t * led_strip)
+{
+    (void) led_strip;
+}
+
+/*
+@brief A strip without hardware whose show captures the bytes on the wire.
+*/
+static inline led_strip_t * led_strip_test_create(uint32_t num_leds,
+                                                  const led_strip_protocol_t * protocol)
+{
+    led_strip_t * led_strip = led_strip_create_no_backend_protocol(num_leds, protocol);
+
+    if (led_strip) {
+        led_strip->show = &led_strip_test_show;
+        led_strip->destroy = &led_strip_test_destroy;
+    }
+
+    return led_strip;
+}
+
+static inline int led_strip_test_result(const char * name)
+{
+    if (led_strip_test_failures) {
+        fprintf(stderr, "%s: %d checks failed\n", name, led_strip_test_failures);
+        return 1;
+    }
+
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif
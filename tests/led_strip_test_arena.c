@@ -0,0 +1,141 @@
+/*
+@file led_strip_test_arena.c
+
+@brief Checks that arenas hand out aligned memory until they are full, that
+       strips and particle systems fit in exactly their required size and
+       send the same as strips on the heap, that a failed create takes
+       nothing, and that destroy leaves the memory of the arena alone.
+*/
+#include "led_strip_test.h"
+#include "led_strip_particles.h"
+#include "led_strip_snapshot.h"
+#include "led_strip_power.h"
+
+#define LEDS 50
+
+// uint64_t keeps the memory aligned to LED_STRIP_ARENA_ALIGN
+static uint64_t memory[2048];
+
+static void test_alloc(void)
+{
+    led_strip_arena_t arena;
+    led_strip_arena_init(&arena, memory, 64);
+
+    uint8_t * a = (uint8_t *) led_strip_arena_alloc(&arena, 1);
+    uint8_t * b = (uint8_t *) led_strip_arena_alloc(&arena, 13);
+    CHECK(a == (uint8_t *) memory);
+    CHECK(b == a + LED_STRIP_ARENA_ALIGN);
+    CHECK_EQUAL((uintptr_t) b % LED_STRIP_ARENA_ALIGN, 0);
+    CHECK_EQUAL(arena.used, LED_STRIP_ARENA_SIZE(1) + LED_STRIP_ARENA_SIZE(13));
+
+    // The rest fits exactly, and nothing after it
+    CHECK(led_strip_arena_alloc(&arena, 64 - arena.used) != NULL);
+    CHECK(led_strip_arena_alloc(&arena, 1) == NULL);
+    CHECK_EQUAL(arena.used, 64);
+
+    // A size that wraps around when rounded up must not fit either
+    led_strip_arena_reset(&arena);
+    CHECK(led_strip_arena_alloc(&arena, 65) == NULL);
+    CHECK(led_strip_arena_alloc(&arena, (size_t) -1) == NULL);
+    CHECK(led_strip_arena_alloc(&arena, 8) == (void *) memory);
+}
+
+static void test_strip(const led_strip_protocol_t * protocol)
+{
+    size_t size = led_strip_required_size(LEDS, protocol);
+    CHECK(size <= sizeof(memory));
+    CHECK_EQUAL(size % LED_STRIP_ARENA_ALIGN, 0);
+
+    // One byte short takes nothing from the arena
+    led_strip_arena_t arena;
+    led_strip_arena_init(&arena, memory, size - 1);
+    CHECK(led_strip_create_no_backend_arena(&arena, LEDS, protocol) == NULL);
+    CHECK_EQUAL(arena.used, 0);
+    CHECK(led_strip_create_no_backend_in(memory, size - 1, LEDS, protocol) == NULL);
+
+    // Exactly the required size is used up by the strip and its buffers
+    led_strip_arena_init(&arena, memory, size);
+    led_strip_t * in_arena = led_strip_create_no_backend_arena(&arena, LEDS, protocol);
+    CHECK(in_arena != NULL);
+    if (in_arena == NULL) {
+        return;
+    }
+    CHECK_EQUAL(arena.used, size);
+    in_arena->show = &led_strip_test_show;
+    in_arena->destroy = &led_strip_test_destroy;
+
+    led_strip_t * on_heap = led_strip_test_create(LEDS, protocol);
+    for (uint32_t p = 0; p < LEDS; p++) {
+        led_strip_set_pixel_color_and_brightness(in_arena, p, (uint8_t) p, 2, 3, 17);
+        led_strip_set_pixel_color_and_brightness(on_heap, p, (uint8_t) p, 2, 3, 17);
+    }
+
+    static uint8_t wire[sizeof(led_strip_test_wire)];
+    CHECK_EQUAL(led_strip_show(on_heap), 0);
+    uint32_t wire_len = led_strip_test_wire_len;
+    memcpy(wire, led_strip_test_wire, wire_len);
+    CHECK_EQUAL(led_strip_show(in_arena), 0);
+    CHECK_EQUAL(led_strip_test_wire_len, wire_len);
+    CHECK(memcmp(led_strip_test_wire, wire, wire_len) == 0);
+
+    // What the strip allocates later is freed by destroy, the arena is not
+    CHECK_EQUAL(led_strip_power_enable(in_arena, NULL, 0), 0);
+    led_strip_snapshot_t * snapshot = led_strip_snapshot_save(in_arena);
+    led_strip_snapshot_destroy(snapshot);
+    led_strip_destroy(in_arena);
+    led_strip_destroy(on_heap);
+}
+
+static void test_shared(void)
+{
+    // Two strips and a particle system side by side
+    size_t strip_size = led_strip_required_size(LEDS, &led_strip_protocol_apa102);
+    size_t particles_size = led_strip_particles_required_size(8);
+    led_strip_arena_t arena;
+    led_strip_arena_init(&arena, memory, 2 * strip_size + particles_size);
+
+    led_strip_t * first = led_strip_create_no_backend_arena(&arena, LEDS,
+                                                            &led_strip_protocol_apa102);
+    led_strip_t * second = led_strip_create_no_backend_arena(&arena, LEDS,
+                                                             &led_strip_protocol_apa102);
+    led_strip_particles_t * particles = led_strip_particles_create_arena(&arena, 8, LEDS);
+    CHECK(first != NULL);
+    CHECK(second != NULL);
+    CHECK(particles != NULL);
+    if (first == NULL || second == NULL || particles == NULL) {
+        return;
+    }
+    CHECK_EQUAL(arena.used, arena.size);
+    CHECK(led_strip_particles_create_arena(&arena, 1, LEDS) == NULL);
+
+    // Writing one does not reach into the other
+    led_strip_set_color_and_brightness(first, 255, 255, 255, PIXEL_MAX_BRIGHTNESS);
+    led_strip_particles_spawn(particles, 0, 0, 255, 0, 0, 10);
+    led_strip_particles_render(particles, second);
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(second, 1, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 0);
+    CHECK_EQUAL(g, 0);
+    led_strip_get_pixel_color_and_brightness(second, 0, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 255);
+    CHECK_EQUAL(g, 0);
+    led_strip_get_pixel_color_and_brightness(first, LEDS - 1, &r, &g, &b, &brightness);
+    CHECK_EQUAL(b, 255);
+
+    // Reset makes the memory available for new objects
+    led_strip_particles_destroy(particles);
+    led_strip_arena_reset(&arena);
+    CHECK(led_strip_create_no_backend_arena(&arena, LEDS, &led_strip_protocol_apa102) == first);
+}
+
+int main(void)
+{
+    test_alloc();
+    test_strip(&led_strip_protocol_apa102);
+    test_strip(&led_strip_protocol_sk9822);
+    test_strip(&led_strip_protocol_hd107s);
+    test_strip(&led_strip_protocol_ws2801);
+    test_shared();
+
+    return led_strip_test_result("led_strip_test_arena");
+}
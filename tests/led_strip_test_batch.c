@@ -0,0 +1,166 @@
+/*
+@file led_strip_test_batch.c
+
+@brief Checks that applying a batch gives the same pixels as calling the
+       recorded functions directly, also on reversed views, with operations
+       that move pixels and with operations that are dropped as overwritten.
+*/
+#include "led_strip_test.h"
+#include "led_strip_batch.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#define LEDS 64
+#define OPS 16
+#define ROUNDS 200
+
+static uint32_t random_state = 1;
+
+static uint32_t random_next(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+// Record one random operation in the batch and apply it to the reference
+static int random_op(led_strip_batch_t * batch, led_strip_t * reference)
+{
+    uint32_t num_leds = reference->num_leds;
+    // Past the end now and then, to check clamping
+    uint32_t p = random_next() % (num_leds + 4);
+    uint32_t count = random_next() % (num_leds / 2);
+    uint8_t r = (uint8_t) random_next();
+    uint8_t g = (uint8_t) random_next();
+    uint8_t b = (uint8_t) random_next();
+    uint8_t brightness = (uint8_t) (random_next() % (PIXEL_MAX_BRIGHTNESS + 1));
+
+    switch (random_next() % 13) {
+    case 0:
+        led_strip_set_pixel_color_and_brightness(reference, p, r, g, b, brightness);
+        return led_strip_batch_set_pixel_color_and_brightness(batch, p, r, g, b, brightness);
+    case 1:
+        led_strip_set_pixel_color(reference, p, r, g, b);
+        return led_strip_batch_set_pixel_color(batch, p, r, g, b);
+    case 2:
+        led_strip_set_pixel_brightness(reference, p, brightness);
+        return led_strip_batch_set_pixel_brightness(batch, p, brightness);
+    case 3:
+        led_strip_set_color_and_brightness(reference, r, g, b, brightness);
+        return led_strip_batch_set_color_and_brightness(batch, r, g, b, brightness);
+    case 4:
+        led_strip_set_color(reference, r, g, b);
+        return led_strip_batch_set_color(batch, r, g, b);
+    case 5:
+        led_strip_set_brightness(reference, brightness);
+        return led_strip_batch_set_brightness(batch, brightness);
+    case 6:
+        led_strip_push_pixel_front(reference, r, g, b, brightness);
+        return led_strip_batch_push_pixel_front(batch, r, g, b, brightness);
+    case 7:
+        led_strip_push_pixel_back(reference, r, g, b, brightness);
+        return led_strip_batch_push_pixel_back(batch, r, g, b, brightness);
+    case 8:
+        led_strip_rotate_left(reference);
+        return led_strip_batch_rotate_left(batch);
+    case 9:
+        led_strip_rotate_right(reference);
+        return led_strip_batch_rotate_right(batch);
+    case 10:
+        for (uint32_t i = p; i < p + count; i++) {
+            led_strip_set_pixel_color_and_brightness(reference, i, r, g, b, brightness);
+        }
+        return led_strip_batch_set_range_color_and_brightness(batch, p, count, r, g, b,
+                                                              brightness);
+    case 11:
+        for (uint32_t i = p; i < p + count; i++) {
+            led_strip_set_pixel_color(reference, i, r, g, b);
+        }
+        return led_strip_batch_set_range_color(batch, p, count, r, g, b);
+    default:
+        for (uint32_t i = p; i < p + count; i++) {
+            led_strip_set_pixel_brightness(reference, i, brightness);
+        }
+        return led_strip_batch_set_range_brightness(batch, p, count, brightness);
+    }
+}
+
+static void test_same_as_direct(uint32_t offset, uint32_t length, int reversed)
+{
+    led_strip_t * expected = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * actual = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * expected_view = led_strip_view_create(expected, offset, length, reversed);
+    led_strip_t * actual_view = led_strip_view_create(actual, offset, length, reversed);
+    led_strip_batch_t * batch = led_strip_batch_create(actual_view, OPS);
+
+    // The estimate must be recounted after a batch
+    CHECK_EQUAL(led_strip_power_enable(actual, NULL, 0), 0);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        uint32_t ops = 1 + random_next() % OPS;
+        for (uint32_t i = 0; i < ops; i++) {
+            CHECK_EQUAL(random_op(batch, expected_view), 0);
+        }
+        led_strip_batch_apply(batch);
+
+        CHECK(memcmp(expected->pixels, actual->pixels, LEDS * sizeof(uint32_t)) == 0);
+    }
+
+    uint32_t tracked = led_strip_power_estimate_ma(actual);
+    led_strip_power_disable(actual);
+    CHECK_EQUAL(led_strip_power_enable(actual, NULL, 0), 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(actual));
+
+    led_strip_batch_destroy(batch);
+    led_strip_destroy(actual_view);
+    led_strip_destroy(expected_view);
+    led_strip_destroy(actual);
+    led_strip_destroy(expected);
+}
+
+static void test_full(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_batch_t * batch = led_strip_batch_create(strip, 2);
+
+    led_strip_set_color_and_brightness(strip, 1, 2, 3, 4);
+    CHECK_EQUAL(led_strip_batch_set_pixel_color(batch, 1, 255, 0, 0), 0);
+    CHECK_EQUAL(led_strip_batch_rotate_left(batch), 0);
+    CHECK_EQUAL(led_strip_batch_set_pixel_color(batch, 2, 0, 255, 0), -1);
+    CHECK_EQUAL(led_strip_batch_rotate_right(batch), -1);
+
+    // Coloring every pixel drops the color fill before it, which makes room
+    CHECK_EQUAL(led_strip_batch_set_color(batch, 0, 0, 255), 0);
+    CHECK_EQUAL(led_strip_batch_set_pixel_color(batch, 2, 0, 255, 0), -1);
+
+    // Resetting discards the recorded operations
+    led_strip_batch_reset(batch);
+    led_strip_batch_apply(batch);
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, 1, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 1);
+    CHECK_EQUAL(brightness, 4);
+
+    // Fills of every pixel replace the earlier ones, so they never fill up
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQUAL(led_strip_batch_set_color_and_brightness(batch, (uint8_t) i, 0, 0, 1), 0);
+        CHECK_EQUAL(led_strip_batch_set_brightness(batch, 9), 0);
+    }
+    led_strip_batch_apply(batch);
+    led_strip_get_pixel_color_and_brightness(strip, LEDS - 1, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 9);
+    CHECK_EQUAL(brightness, 9);
+
+    led_strip_batch_destroy(batch);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_same_as_direct(0, LEDS, 0);
+    test_same_as_direct(0, LEDS, 1);
+    test_same_as_direct(5, 40, 0);
+    test_same_as_direct(5, 40, 1);
+    test_full();
+
+    return led_strip_test_result("led_strip_test_batch");
+}
@@ -0,0 +1,90 @@
+/*
+@file led_strip_test_calibration.c
+
+@brief Checks that show sends the colors of the gamma curve and trims while
+       the pixels keep the linear colors, and that views are rejected.
+*/
+#include "led_strip_test.h"
+#include "led_strip_calibration.h"
+#include "led_strip_view.h"
+
+#define LEDS 8
+
+// The APA102 frame of pixel p starts after the 4 byte start frame, blue first
+#define WIRE_B(p) led_strip_test_wire[4 + 4 * (p) + 1]
+#define WIRE_G(p) led_strip_test_wire[4 + 4 * (p) + 2]
+#define WIRE_R(p) led_strip_test_wire[4 + 4 * (p) + 3]
+
+static void test_gamma(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    CHECK_EQUAL(led_strip_gamma_2_8[0], 0);
+    CHECK_EQUAL(led_strip_gamma_2_8[128], 37);
+    CHECK_EQUAL(led_strip_gamma_2_8[255], 255);
+    CHECK_EQUAL(led_strip_gamma_2_2[128], 56);
+
+    led_strip_clear(strip);
+    led_strip_set_pixel_color(strip, 2, 128, 255, 0);
+    CHECK_EQUAL(led_strip_calibration_set(strip, led_strip_gamma_2_8, 255, 255, 255), 0);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(WIRE_R(2), 37);
+    CHECK_EQUAL(WIRE_G(2), 255);
+    CHECK_EQUAL(WIRE_B(2), 0);
+
+    // The pixel keeps the linear color
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, 2, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 128);
+
+    // Disabling sends the colors as they are set again
+    led_strip_calibration_disable(strip);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(WIRE_R(2), 128);
+
+    led_strip_destroy(strip);
+}
+
+static void test_trim(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    // Keep half of green after a linear curve
+    led_strip_set_color(strip, 200, 200, 200);
+    CHECK_EQUAL(led_strip_calibration_set(strip, NULL, 255, 127, 255), 0);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(WIRE_R(LEDS - 1), 200);
+    CHECK_EQUAL(WIRE_G(LEDS - 1), 100);
+    CHECK_EQUAL(WIRE_B(LEDS - 1), 200);
+
+    led_strip_destroy(strip);
+}
+
+static void test_view(void)
+{
+    static const uint8_t dark[256] = { 0 };
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 2, 4, 1);
+
+    CHECK_EQUAL(led_strip_calibration_set(view, led_strip_gamma_2_8, 255, 255, 255), -1);
+    CHECK_EQUAL(led_strip_calibration_set_tables(view, dark, dark, dark), -1);
+
+    // A view is sent by its parent, with the tables of the parent
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_calibration_set(strip, led_strip_gamma_2_8, 255, 255, 255), 0);
+    led_strip_set_pixel_color(view, 0, 128, 0, 0);
+    CHECK_EQUAL(led_strip_show(view), 0);
+    CHECK_EQUAL(WIRE_R(2 + 3), 37);
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_gamma();
+    test_trim();
+    test_view();
+
+    return led_strip_test_result("led_strip_test_calibration");
+}
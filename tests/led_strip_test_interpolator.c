@@ -0,0 +1,176 @@
+/*
+@file led_strip_test_interpolator.c
+
+@brief Checks the blends between two keyframes, also on reversed views and
+       with the power estimate enabled, and that show blends towards the next
+       keyframe and ends on it, also when the clock wraps around.
+*/
+#include "led_strip_test.h"
+#include "led_strip_interpolator.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#define LEDS 40
+#define MAX LED_STRIP_INTERPOLATOR_WEIGHT_MAX
+
+static void check_pixel(led_strip_t * strip, uint32_t p,
+                        uint8_t r, uint8_t g, uint8_t b, uint8_t brightness)
+{
+    uint8_t actual_r, actual_g, actual_b, actual_brightness;
+    led_strip_get_pixel_color_and_brightness(strip, p, &actual_r, &actual_g, &actual_b,
+                                             &actual_brightness);
+    CHECK_EQUAL(actual_r, r);
+    CHECK_EQUAL(actual_g, g);
+    CHECK_EQUAL(actual_b, b);
+    CHECK_EQUAL(actual_brightness, brightness);
+}
+
+static void test_render(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    led_strip_set_color_and_brightness(strip, 0, 100, 255, 2);
+    led_strip_interpolator_t * interpolator = led_strip_interpolator_create(strip);
+    CHECK(interpolator != NULL);
+    if (interpolator == NULL) {
+        return;
+    }
+    led_strip_set_color_and_brightness(strip, 255, 50, 255, 31);
+    led_strip_interpolator_push_keyframe(interpolator);
+
+    led_strip_interpolator_render(interpolator, 0);
+    check_pixel(strip, 0, 0, 100, 255, 2);
+
+    // Every byte including the brightness is blended, rounding down
+    led_strip_interpolator_render(interpolator, MAX / 2);
+    check_pixel(strip, 7, 127, 75, 255, 16);
+
+    led_strip_interpolator_render(interpolator, MAX / 4);
+    check_pixel(strip, LEDS - 1, 63, 87, 255, 9);
+
+    // Weights past the maximum select the next keyframe
+    led_strip_interpolator_render(interpolator, MAX + 100);
+    check_pixel(strip, 3, 255, 50, 255, 31);
+
+    // Pushing again makes the old next keyframe the previous one
+    led_strip_set_color_and_brightness(strip, 1, 2, 3, 4);
+    led_strip_interpolator_push_keyframe(interpolator);
+    led_strip_interpolator_render(interpolator, 0);
+    check_pixel(strip, 0, 255, 50, 255, 31);
+    led_strip_interpolator_render(interpolator, MAX);
+    check_pixel(strip, 0, 1, 2, 3, 4);
+
+    led_strip_interpolator_destroy(interpolator);
+    led_strip_destroy(strip);
+}
+
+static void test_reversed_view(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 10, 20, 1);
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    led_strip_interpolator_t * interpolator = led_strip_interpolator_create(view);
+    led_strip_set_pixel_color(view, 0, 200, 0, 0);
+    led_strip_set_pixel_color(view, 19, 0, 200, 0);
+    led_strip_interpolator_push_keyframe(interpolator);
+    led_strip_interpolator_render(interpolator, MAX / 2);
+
+    // Pixel 0 of the view is the last LED of its range, and nothing outside
+    // the range is written
+    check_pixel(strip, 29, 100, 0, 0, PIXEL_MAX_BRIGHTNESS);
+    check_pixel(strip, 10, 0, 100, 0, PIXEL_MAX_BRIGHTNESS);
+    check_pixel(strip, 9, 0, 0, 0, PIXEL_MAX_BRIGHTNESS);
+    check_pixel(strip, 30, 0, 0, 0, PIXEL_MAX_BRIGHTNESS);
+
+    // The estimate of the parent is recounted after a render of the view
+    uint32_t tracked = led_strip_power_estimate_ma(strip);
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+
+    led_strip_interpolator_destroy(interpolator);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+// Every call of the clock is 100 us after the previous one
+static uint32_t clock_us = 0;
+
+static uint32_t fake_clock(void)
+{
+    clock_us += 100;
+    return clock_us;
+}
+
+static uint8_t shown_red[64];
+static uint32_t shown_frames = 0;
+
+static void record_red(led_strip_t * led_strip, const uint32_t * pixels, void * arg)
+{
+    (void) led_strip;
+    (void) arg;
+    if (shown_frames < sizeof(shown_red)) {
+        shown_red[shown_frames] = (uint8_t) (pixels[0] >> 24);
+    }
+    shown_frames++;
+}
+
+static void test_show(uint32_t start_us)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    led_strip_clear(strip);
+    led_strip_interpolator_t * interpolator = led_strip_interpolator_create(strip);
+    led_strip_set_color(strip, 255, 0, 0);
+    led_strip_interpolator_push_keyframe(interpolator);
+    led_strip_set_show_hook(strip, &record_red, NULL);
+
+    clock_us = start_us;
+    shown_frames = 0;
+    int frames = led_strip_interpolator_show(interpolator, 2000, &fake_clock);
+
+    // About one frame per show, the last one the next keyframe
+    CHECK_EQUAL(frames, shown_frames);
+    CHECK(frames >= 5 && frames <= 20);
+    CHECK_EQUAL(shown_red[frames - 1], 255);
+    for (int i = 1; i < frames; i++) {
+        CHECK(shown_red[i] > shown_red[i - 1]);
+    }
+    // The first frame is already blended for when it becomes visible
+    CHECK(shown_red[0] > 0);
+
+    led_strip_interpolator_destroy(interpolator);
+    led_strip_destroy(strip);
+}
+
+static int failing_show(led_strip_t * led_strip)
+{
+    (void) led_strip;
+    return -1;
+}
+
+static void test_show_error(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_interpolator_t * interpolator = led_strip_interpolator_create(strip);
+
+    strip->show = &failing_show;
+    CHECK_EQUAL(led_strip_interpolator_show(interpolator, 2000, &fake_clock), -1);
+
+    led_strip_interpolator_destroy(interpolator);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_render();
+    test_reversed_view();
+    test_show(0);
+    test_show(0xFFFFFFFF - 500);
+    test_show_error();
+
+    return led_strip_test_result("led_strip_test_interpolator");
+}
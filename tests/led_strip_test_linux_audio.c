@@ -0,0 +1,186 @@
+/*
+@file led_strip_test_linux_audio.c
+
+@brief Runs the audio pipeline offline, from a generated WAV file to a
+       capture of the shown stream, and checks what was shown. Also checks
+       that malformed WAV headers are rejected.
+*/
+#include "led_strip_test.h"
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_audio.h"
+
+#include <math.h>
+#include <stdlib.h> // for mkstemp
+#include <unistd.h> // for close, unlink
+
+#define SAMPLE_RATE 44100
+#define BLOCK_SIZE 512
+#define BLOCKS 40
+#define LEDS 64
+#define BANDS 8
+
+// APA102 start frame, pixels and end frame
+#define FRAME_LEN (4 + LEDS * 4 + (LEDS + 15) / 16)
+
+static void put_u16(uint8_t * out, uint32_t value)
+{
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+}
+
+static void put_u32(uint8_t * out, uint32_t value)
+{
+    put_u16(out, value & 0xFFFF);
+    put_u16(out + 2, value >> 16);
+}
+
+// A 16 bit PCM WAV file of a sine wave, optionally followed by a LIST chunk
+// of trailing bytes that are not samples
+static void write_wav(const char * path, uint32_t sample_rate, uint32_t channels,
+                      uint32_t frames, float frequency, uint32_t trailing)
+{
+    uint8_t header[44];
+    uint32_t data_len = frames * channels * 2;
+
+    memcpy(header, "RIFF", 4);
+    put_u32(header + 4, 36 + data_len + (trailing ? 8 + trailing : 0));
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, 1);
+    put_u16(header + 22, channels);
+    put_u32(header + 24, sample_rate);
+    put_u32(header + 28, sample_rate * channels * 2);
+    put_u16(header + 32, channels * 2);
+    put_u16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_u32(header + 40, data_len);
+
+    FILE * file = fopen(path, "wb");
+    fwrite(header, 1, sizeof(header), file);
+    for (uint32_t i = 0; i < frames; i++) {
+        float rate = sample_rate ? (float) sample_rate : 1.0f;
+        int16_t sample = (int16_t) (16000.0f * sinf(2.0f * (float) M_PI * frequency * i / rate));
+        for (uint32_t c = 0; c < channels; c++) {
+            uint8_t bytes[2];
+            put_u16(bytes, (uint16_t) sample);
+            fwrite(bytes, 1, 2, file);
+        }
+    }
+    if (trailing) {
+        uint8_t chunk[8];
+        memcpy(chunk, "LIST", 4);
+        put_u32(chunk + 4, trailing);
+        fwrite(chunk, 1, 8, file);
+        for (uint32_t i = 0; i < trailing; i++) {
+            fputc(0x7F, file);
+        }
+    }
+    fclose(file);
+}
+
+// LEDs lit in the segment of a band in a captured frame
+static uint32_t lit_in_band(const uint8_t * frame, uint32_t band)
+{
+    uint32_t first = band * LEDS / BANDS;
+    uint32_t count = (band + 1) * LEDS / BANDS - first;
+    uint32_t lit = 0;
+
+    for (uint32_t p = first; p < first + count; p++) {
+        const uint8_t * pixel = frame + 4 + 4 * p;
+        if (pixel[1] || pixel[2] || pixel[3]) {
+            lit++;
+        }
+    }
+    return lit;
+}
+
+static void test_tone(uint32_t channels, uint32_t trailing)
+{
+    char wav_path[] = "/tmp/led_strip_test_audio_XXXXXX";
+    char capture_path[] = "/tmp/led_strip_test_audio_XXXXXX";
+    close(mkstemp(wav_path));
+    close(mkstemp(capture_path));
+
+    // 1 kHz is in band 4 of 8 from 40 Hz to 16 kHz. A partial block at the
+    // end is not shown, also when a trailing chunk would fill it up.
+    write_wav(wav_path, SAMPLE_RATE, channels, BLOCKS * BLOCK_SIZE + 100, 1000.0f, trailing);
+
+    led_strip_t * strip = led_strip_create_linux_file(capture_path, 0, LEDS);
+    led_strip_audio_t * audio = led_strip_audio_create_wav(strip, wav_path, BLOCK_SIZE, BANDS, 0);
+    CHECK(audio != NULL);
+    if (audio == NULL) {
+        led_strip_destroy(strip);
+        return;
+    }
+
+    int ret;
+    uint32_t processed = 0;
+    while ((ret = led_strip_audio_process(audio)) == 0) {
+        processed++;
+    }
+    CHECK_EQUAL(ret, 1);
+    CHECK_EQUAL(processed, BLOCKS);
+
+    led_strip_audio_stats_t stats;
+    led_strip_audio_get_stats(audio, &stats);
+    CHECK_EQUAL(stats.blocks, BLOCKS);
+    CHECK_EQUAL(stats.block_us, (uint64_t) BLOCK_SIZE * 1000000 / SAMPLE_RATE);
+
+    led_strip_audio_destroy(audio);
+    led_strip_destroy(strip);
+
+    // One frame on the wire per block
+    static uint8_t capture[BLOCKS * FRAME_LEN + 1];
+    FILE * file = fopen(capture_path, "rb");
+    size_t len = fread(capture, 1, sizeof(capture), file);
+    fclose(file);
+    CHECK_EQUAL(len, BLOCKS * FRAME_LEN);
+
+    // Once the tone is steady its band is full, and bands far from it dark
+    const uint8_t * last = capture + (BLOCKS - 1) * FRAME_LEN;
+    CHECK_EQUAL(lit_in_band(last, 4), LEDS / BANDS);
+    CHECK_EQUAL(lit_in_band(last, 0), 0);
+    CHECK_EQUAL(lit_in_band(last, 7), 0);
+
+    // The band is lit in its color: green with a little blue
+    const uint8_t * pixel = last + 4 + 4 * (4 * LEDS / BANDS);
+    CHECK_EQUAL(pixel[0], 0xFF);
+    CHECK_EQUAL(pixel[1], 36);
+    CHECK_EQUAL(pixel[2], 219);
+    CHECK_EQUAL(pixel[3], 0);
+
+    unlink(wav_path);
+    unlink(capture_path);
+}
+
+static void test_bad_headers(void)
+{
+    char wav_path[] = "/tmp/led_strip_test_audio_XXXXXX";
+    close(mkstemp(wav_path));
+    led_strip_t * strip = led_strip_create_linux_file("/dev/null", 0, LEDS);
+
+    write_wav(wav_path, 0, 1, BLOCK_SIZE, 1000.0f, 0);
+    CHECK(led_strip_audio_create_wav(strip, wav_path, BLOCK_SIZE, BANDS, 0) == NULL);
+
+    write_wav(wav_path, SAMPLE_RATE, 0, BLOCK_SIZE, 1000.0f, 0);
+    CHECK(led_strip_audio_create_wav(strip, wav_path, BLOCK_SIZE, BANDS, 0) == NULL);
+
+    FILE * file = fopen(wav_path, "wb");
+    fwrite("RIFF", 1, 4, file);
+    fclose(file);
+    CHECK(led_strip_audio_create_wav(strip, wav_path, BLOCK_SIZE, BANDS, 0) == NULL);
+
+    led_strip_destroy(strip);
+    unlink(wav_path);
+}
+
+int main(void)
+{
+    test_tone(1, 0);
+    test_tone(2, 0);
+    test_tone(1, 4 * BLOCK_SIZE);
+    test_tone(2, 4 * BLOCK_SIZE);
+    test_bad_headers();
+
+    return led_strip_test_result("led_strip_test_linux_audio");
+}
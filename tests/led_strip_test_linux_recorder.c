@@ -0,0 +1,239 @@
+/*
+@file led_strip_test_linux_recorder.c
+
+@brief Records shown frames and reads them back, checking that every frame,
+       its timing and the protocol of the strip survive the round trip, that
+       a replay through the power limit and calibration of the strip sends
+       the same again, and that damaged files are rejected.
+*/
+#include "led_strip_test.h"
+#include "led_strip_linux_recorder.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+#include "led_strip_calibration.h"
+
+#include <stdlib.h> // for mkstemp
+#include <unistd.h> // for close, unlink, usleep
+
+#define LEDS 200
+#define FRAMES 30
+
+static uint32_t shown[FRAMES][LEDS];
+static uint32_t shown_changed[FRAMES];
+
+// Change a few pixels per frame, some frames none and one frame all of them
+static void draw(led_strip_t * strip, int frame)
+{
+    if (frame == 10) {
+        led_strip_set_color_and_brightness(strip, 1, 2, 3, 4);
+        return;
+    }
+    for (uint32_t i = 0; i < (uint32_t) (frame % 4) * 3; i++) {
+        uint32_t p = (uint32_t) (frame * 37 + i * 11) % strip->num_leds;
+        led_strip_set_pixel_color_and_brightness(strip, p, (uint8_t) frame, (uint8_t) i,
+                                                 (uint8_t) p, (uint8_t) (i % 32));
+    }
+}
+
+static void record(const char * path, led_strip_t * strip, led_strip_t * sender)
+{
+    led_strip_recorder_t * recorder = led_strip_recorder_start(strip, path, FRAMES);
+    CHECK(recorder != NULL);
+    if (recorder == NULL) {
+        return;
+    }
+
+    // Times are relative to the first frame, not to the start of recording
+    usleep(20000);
+
+    uint32_t previous[LEDS];
+    memset(previous, 0, sizeof(previous));
+    uint64_t total_changed = 0;
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        draw(strip, frame);
+        CHECK_EQUAL(led_strip_show(strip), 0);
+
+        // Shown pixels are in the order they are sent
+        memcpy(shown[frame], sender->pixels, strip->num_leds * sizeof(uint32_t));
+        shown_changed[frame] = 0;
+        for (uint32_t p = 0; p < strip->num_leds; p++) {
+            shown_changed[frame] += (shown[frame][p] != previous[p]);
+        }
+        memcpy(previous, shown[frame], sizeof(previous));
+        total_changed += shown_changed[frame];
+    }
+
+    led_strip_recorder_stats_t stats;
+    CHECK_EQUAL(led_strip_recorder_stop(recorder, &stats), 0);
+    CHECK_EQUAL(stats.frames, FRAMES);
+    CHECK_EQUAL(stats.dropped, 0);
+    CHECK_EQUAL(stats.changed, total_changed);
+    CHECK_EQUAL(stats.last_error, 0);
+}
+
+static void check_replay(const char * path, uint32_t num_leds,
+                         const led_strip_protocol_t * protocol)
+{
+    led_strip_recording_t * recording = led_strip_recording_open(path);
+    CHECK(recording != NULL);
+    if (recording == NULL) {
+        return;
+    }
+
+    CHECK_EQUAL(led_strip_recording_num_leds(recording), num_leds);
+    CHECK(led_strip_recording_protocol(recording) == protocol);
+
+    uint64_t time_us = 0;
+    uint64_t last_us = 0;
+    uint32_t changed = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        CHECK_EQUAL(led_strip_recording_next(recording, &time_us, &changed), 1);
+        CHECK_EQUAL(changed, shown_changed[frame]);
+        CHECK(memcmp(led_strip_recording_pixels(recording), shown[frame],
+                     num_leds * sizeof(uint32_t)) == 0);
+        if (frame == 0) {
+            CHECK(time_us < 20000);
+        }
+        CHECK(time_us >= last_us);
+        last_us = time_us;
+    }
+    CHECK_EQUAL(led_strip_recording_next(recording, &time_us, &changed), 0);
+
+    // Applying gives a strip the last frame to show again
+    led_strip_t * strip = led_strip_test_create(num_leds, protocol);
+    led_strip_recording_apply(recording, strip);
+    CHECK(memcmp(strip->pixels, shown[FRAMES - 1], num_leds * sizeof(uint32_t)) == 0);
+    led_strip_destroy(strip);
+
+    led_strip_recording_close(recording);
+}
+
+static void test_round_trip(const led_strip_protocol_t * protocol)
+{
+    char path[] = "/tmp/led_strip_test_recorder_XXXXXX";
+    close(mkstemp(path));
+
+    led_strip_t * strip = led_strip_test_create(LEDS, protocol);
+    record(path, strip, strip);
+    led_strip_destroy(strip);
+
+    check_replay(path, LEDS, protocol);
+    unlink(path);
+}
+
+static void test_view(void)
+{
+    char path[] = "/tmp/led_strip_test_recorder_XXXXXX";
+    close(mkstemp(path));
+
+    // A view is recorded with the protocol of the strip it belongs to
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_hd107s);
+    led_strip_t * view = led_strip_view_create(strip, 50, 100, 0);
+    record(path, view, view);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+
+    check_replay(path, 100, &led_strip_protocol_hd107s);
+    unlink(path);
+}
+
+// A strip that limits its current and corrects its colors on show
+static led_strip_t * create_corrected(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 250), 0);
+    CHECK_EQUAL(led_strip_calibration_set(strip, led_strip_gamma_2_2, 255, 200, 180), 0);
+    return strip;
+}
+
+static void test_corrected(void)
+{
+    char path[] = "/tmp/led_strip_test_recorder_XXXXXX";
+    close(mkstemp(path));
+
+    // The colors as set are recorded, not the ones the passes of show sent
+    led_strip_t * strip = create_corrected();
+    record(path, strip, strip);
+    CHECK(led_strip_power_get_scale(strip) < LED_STRIP_POWER_SCALE_NONE);
+    static uint8_t wire[sizeof(led_strip_test_wire)];
+    uint32_t wire_len = led_strip_test_wire_len;
+    memcpy(wire, led_strip_test_wire, wire_len);
+    led_strip_destroy(strip);
+
+    check_replay(path, LEDS, &led_strip_protocol_apa102);
+
+    // Replayed through the same passes, the last frame is sent the same again
+    led_strip_recording_t * recording = led_strip_recording_open(path);
+    CHECK(recording != NULL);
+    if (recording) {
+        uint64_t time_us;
+        while (led_strip_recording_next(recording, &time_us, NULL) == 1) {
+        }
+        strip = create_corrected();
+        led_strip_recording_apply(recording, strip);
+        CHECK_EQUAL(led_strip_show(strip), 0);
+        CHECK_EQUAL(led_strip_test_wire_len, wire_len);
+        CHECK(memcmp(led_strip_test_wire, wire, wire_len) == 0);
+        led_strip_destroy(strip);
+        led_strip_recording_close(recording);
+    }
+    unlink(path);
+}
+
+static void test_damaged(void)
+{
+    char path[] = "/tmp/led_strip_test_recorder_XXXXXX";
+    close(mkstemp(path));
+
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    record(path, strip, strip);
+    led_strip_destroy(strip);
+
+    static uint8_t data[1 << 16];
+    FILE * file = fopen(path, "rb");
+    size_t len = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    // Cut off in the middle of the last frame
+    file = fopen(path, "wb");
+    fwrite(data, 1, len - 3, file);
+    fclose(file);
+
+    led_strip_recording_t * recording = led_strip_recording_open(path);
+    CHECK(recording != NULL);
+    if (recording) {
+        uint64_t time_us;
+        int ret;
+        int frames = 0;
+        while ((ret = led_strip_recording_next(recording, &time_us, NULL)) == 1) {
+            frames++;
+        }
+        CHECK_EQUAL(ret, -1);
+        CHECK_EQUAL(frames, FRAMES - 1);
+        led_strip_recording_close(recording);
+    }
+
+    // A version this code does not know
+    data[4] = 99;
+    file = fopen(path, "wb");
+    fwrite(data, 1, len, file);
+    fclose(file);
+    CHECK(led_strip_recording_open(path) == NULL);
+
+    unlink(path);
+}
+
+int main(void)
+{
+    test_round_trip(&led_strip_protocol_apa102);
+    test_round_trip(&led_strip_protocol_sk9822);
+    test_round_trip(&led_strip_protocol_ws2801);
+    test_view();
+    test_corrected();
+    test_damaged();
+
+    return led_strip_test_result("led_strip_test_linux_recorder");
+}
@@ -0,0 +1,189 @@
+/*
+@file led_strip_test_linux_render.c
+
+@brief Checks that the render pool runs the kernel exactly once for every
+       pixel, also on reversed views that do not start on a cache line, that
+       every range it hands a kernel is one cache line of the pixels, that a
+       pool can be reused for strips of any length, and that the current
+       estimate is right after kernels wrote from several threads.
+*/
+#include "led_strip_test.h"
+#include "led_strip_linux_render.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#include <stdatomic.h>
+
+#define LEDS 5000
+#define THREADS 4
+
+static _Atomic uint32_t visits[LEDS];
+
+// Every pixel gets a color from its index, and counts its visits
+static void kernel(led_strip_t * led_strip, uint32_t first, uint32_t count, void * arg)
+{
+    uint32_t frame = *(const uint32_t *) arg;
+
+    for (uint32_t p = first; p < first + count; p++) {
+        atomic_fetch_add(&visits[p], 1);
+        led_strip_set_pixel_color_and_brightness(led_strip, p, (uint8_t) p, (uint8_t) (p >> 8),
+                                                 (uint8_t) frame, (uint8_t) (p % 32));
+    }
+}
+
+static void check_pixels(led_strip_t * strip, uint32_t frame)
+{
+    uint32_t wrong = 0;
+
+    for (uint32_t p = 0; p < strip->num_leds; p++) {
+        uint8_t r, g, b, brightness;
+        led_strip_get_pixel_color_and_brightness(strip, p, &r, &g, &b, &brightness);
+        wrong += (r != (uint8_t) p || g != (uint8_t) (p >> 8) || b != (uint8_t) frame ||
+                  brightness != p % 32);
+    }
+    CHECK_EQUAL(wrong, 0);
+}
+
+static void check_visits(uint32_t num_leds)
+{
+    uint32_t wrong = 0;
+
+    for (uint32_t p = 0; p < LEDS; p++) {
+        wrong += (atomic_load(&visits[p]) != (p < num_leds ? 1u : 0u));
+        atomic_store(&visits[p], 0);
+    }
+    CHECK_EQUAL(wrong, 0);
+}
+
+static void test_render(uint32_t offset, uint32_t length, int reversed)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, offset, length, reversed);
+    led_strip_render_t * render = led_strip_render_create(THREADS);
+
+    CHECK(render != NULL);
+    if (render == NULL) {
+        return;
+    }
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    for (uint32_t frame = 0; frame < 20; frame++) {
+        led_strip_render_run(render, view, &kernel, &frame);
+        check_pixels(view, frame);
+        check_visits(length);
+
+        // The estimate of the parent is recounted once the kernels are done
+        uint32_t tracked = led_strip_power_estimate_ma(strip);
+        led_strip_power_disable(strip);
+        CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+        CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+    }
+
+    led_strip_render_stats_t stats;
+    led_strip_render_get_stats(render, &stats);
+    CHECK_EQUAL(stats.frames, 20);
+    CHECK(stats.tiles >= 20 * ((length + LED_STRIP_RENDER_TILE_PIXELS - 1) /
+                               LED_STRIP_RENDER_TILE_PIXELS));
+
+    led_strip_render_destroy(render);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+#define MAX_CALLS 1024
+
+static _Atomic uint32_t num_calls;
+static uint32_t call_first[MAX_CALLS];
+static uint32_t call_count[MAX_CALLS];
+
+static void record_kernel(led_strip_t * led_strip, uint32_t first, uint32_t count, void * arg)
+{
+    (void) led_strip;
+    (void) arg;
+    uint32_t call = atomic_fetch_add(&num_calls, 1);
+    if (call < MAX_CALLS) {
+        call_first[call] = first;
+        call_count[call] = count;
+    }
+}
+
+static void test_tiles(uint32_t offset, uint32_t length, int reversed)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, offset, length, reversed);
+    led_strip_render_t * render = led_strip_render_create(THREADS);
+
+    atomic_store(&num_calls, 0);
+    led_strip_render_run(render, view, &record_kernel, NULL);
+    uint32_t calls = atomic_load(&num_calls);
+    CHECK(calls <= MAX_CALLS);
+
+    // Threads never write to the same cache line, so each range is stored
+    // within one, whichever way the view runs
+    uint32_t covered = 0;
+    uint32_t split = 0;
+    for (uint32_t call = 0; call < calls && call < MAX_CALLS; call++) {
+        uint32_t first = call_first[call];
+        uint32_t last = first + call_count[call] - 1;
+        if (reversed) {
+            uint32_t stored_last = length - 1 - first;
+            first = length - 1 - last;
+            last = stored_last;
+        }
+        uintptr_t first_line = (uintptr_t) &view->pixels[first] / 64;
+        uintptr_t last_line = (uintptr_t) &view->pixels[last] / 64;
+        split += (call_count[call] == 0 || first_line != last_line);
+        covered += call_count[call];
+    }
+    CHECK_EQUAL(split, 0);
+    CHECK_EQUAL(covered, length);
+
+    led_strip_render_destroy(render);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_reuse(uint32_t num_threads)
+{
+    led_strip_render_t * render = led_strip_render_create(num_threads);
+    CHECK(render != NULL);
+    if (render == NULL) {
+        return;
+    }
+
+    // Strips shorter than a tile and longer than all threads' shares
+    static const uint32_t lengths[] = { 1, 5, LED_STRIP_RENDER_TILE_PIXELS, 100, LEDS };
+    uint32_t frame = 3;
+    for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        led_strip_t * strip = led_strip_test_create(lengths[i], &led_strip_protocol_apa102);
+        led_strip_render_run(render, strip, &kernel, &frame);
+        check_pixels(strip, frame);
+        check_visits(lengths[i]);
+        led_strip_destroy(strip);
+    }
+
+    led_strip_render_stats_t stats;
+    led_strip_render_get_stats(render, &stats);
+    CHECK_EQUAL(stats.frames, sizeof(lengths) / sizeof(lengths[0]));
+
+    led_strip_render_destroy(render);
+}
+
+int main(void)
+{
+    test_render(0, LEDS, 0);
+    test_render(0, LEDS, 1);
+    test_render(3, 2001, 0);
+    test_render(7, 4000, 1);
+    test_tiles(0, 1000, 0);
+    test_tiles(5, 1000, 0);
+    test_tiles(5, 1000, 1);
+    test_tiles(13, 7, 1);
+    test_reuse(1);
+    test_reuse(3);
+    test_reuse(0);
+
+    return led_strip_test_result("led_strip_test_linux_render");
+}
@@ -0,0 +1,116 @@
+/*
+@file led_strip_test_linux_rt.c
+
+@brief Checks that a strip shown from the real-time thread writes the same
+       bytes as the strip it wraps would, that its counters add up, and that
+       a configuration it can't apply fails create.
+*/
+#include "led_strip_test.h"
+#include "led_strip_linux_file_backend.h"
+#include "led_strip_linux_rt.h"
+
+#include <stdlib.h> // for mkstemp
+#include <unistd.h> // for close, unlink
+
+#define LEDS 50
+#define FRAMES 20
+
+static void draw(led_strip_t * strip, int frame)
+{
+    for (uint32_t p = 0; p < LEDS; p++) {
+        led_strip_set_pixel_color_and_brightness(strip, p, (uint8_t) (p * 5), (uint8_t) frame,
+                                                 (uint8_t) (255 - p), (uint8_t) (frame % 32));
+    }
+}
+
+static long read_file(const char * path, uint8_t * data, size_t size)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    long len = (long) fread(data, 1, size, file);
+    fclose(file);
+    return len;
+}
+
+static void test_same_bytes(const led_strip_protocol_t * protocol)
+{
+    char direct_path[] = "/tmp/led_strip_test_rt_XXXXXX";
+    char rt_path[] = "/tmp/led_strip_test_rt_XXXXXX";
+    close(mkstemp(direct_path));
+    close(mkstemp(rt_path));
+
+    led_strip_t * direct = led_strip_create_linux_file_protocol(direct_path, 0, LEDS, protocol);
+    led_strip_linux_rt_config_t config;
+    config.lock_memory = 0;
+    config.priority = 0;
+    config.cpu = -1;
+    led_strip_t * rt = led_strip_create_linux_rt(
+        led_strip_create_linux_file_protocol(rt_path, 0, LEDS, protocol), &config);
+
+    CHECK(direct != NULL);
+    CHECK(rt != NULL);
+    if (direct == NULL || rt == NULL) {
+        return;
+    }
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+        draw(direct, frame);
+        draw(rt, frame);
+        CHECK_EQUAL(led_strip_show(direct), 0);
+        CHECK_EQUAL(led_strip_show(rt), 0);
+    }
+
+    // Showing is asynchronous until destroy waits for the last frame
+    led_strip_destroy(direct);
+    led_strip_linux_rt_stats_t stats;
+    led_strip_linux_rt_get_stats(rt, &stats);
+    led_strip_destroy(rt);
+
+    CHECK(stats.frames >= FRAMES - 1);
+    CHECK_EQUAL(stats.errors, 0);
+    CHECK(stats.total_latency_ns >= stats.total_transfer_ns);
+    CHECK(stats.total_latency_ns >= stats.total_wakeup_ns);
+    CHECK(stats.max_latency_ns >= stats.max_transfer_ns);
+
+    static uint8_t direct_data[FRAMES * 512];
+    static uint8_t rt_data[FRAMES * 512];
+    long direct_len = read_file(direct_path, direct_data, sizeof(direct_data));
+    long rt_len = read_file(rt_path, rt_data, sizeof(rt_data));
+    long frame_len = protocol->header_len + LEDS * protocol->bytes_per_pixel +
+                     protocol->footer_len(LEDS);
+
+    CHECK_EQUAL(direct_len, FRAMES * frame_len);
+    CHECK_EQUAL(rt_len, direct_len);
+    CHECK(rt_len == direct_len && memcmp(direct_data, rt_data, (size_t) rt_len) == 0);
+
+    unlink(direct_path);
+    unlink(rt_path);
+}
+
+static void test_config_error(void)
+{
+    // A CPU that does not exist fails create instead of running unpinned
+    led_strip_linux_rt_config_t config;
+    config.lock_memory = 0;
+    config.priority = 0;
+    config.cpu = 1000;
+    led_strip_t * rt = led_strip_create_linux_rt(
+        led_strip_create_linux_file_protocol("/dev/null", 0, LEDS, &led_strip_protocol_apa102),
+        &config);
+
+    CHECK(rt == NULL);
+    if (rt) {
+        led_strip_destroy(rt);
+    }
+}
+
+int main(void)
+{
+    test_same_bytes(&led_strip_protocol_apa102);
+    test_same_bytes(&led_strip_protocol_ws2801);
+    test_config_error();
+
+    return led_strip_test_result("led_strip_test_linux_rt");
+}
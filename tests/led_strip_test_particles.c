@@ -0,0 +1,162 @@
+/*
+@file led_strip_test_particles.c
+
+@brief Checks how particles move, die and are drawn, also on reversed views
+       and with the power estimate enabled.
+*/
+#include "led_strip_test.h"
+#include "led_strip_particles.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#define LEDS 20
+#define ONE LED_STRIP_PARTICLE_ONE
+
+static uint8_t red_of(led_strip_t * strip, uint32_t p)
+{
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, p, &r, &g, &b, &brightness);
+    return r;
+}
+
+static uint32_t lit(led_strip_t * strip)
+{
+    uint32_t count = 0;
+    for (uint32_t p = 0; p < strip->num_leds; p++) {
+        count += (red_of(strip, p) != 0);
+    }
+    return count;
+}
+
+static void test_spawn(void)
+{
+    led_strip_particles_t * particles = led_strip_particles_create(2, LEDS);
+
+    CHECK_EQUAL(led_strip_particles_spawn(particles, -1, 0, 255, 0, 0, 10), -1);
+    CHECK_EQUAL(led_strip_particles_spawn(particles, LEDS * ONE, 0, 255, 0, 0, 10), -1);
+    CHECK_EQUAL(led_strip_particles_spawn(particles, 0, 0, 255, 0, 0, 10), 0);
+    CHECK_EQUAL(led_strip_particles_spawn(particles, LEDS * ONE - 1, 0, 255, 0, 0, 10), 0);
+    CHECK_EQUAL(led_strip_particles_spawn(particles, ONE, 0, 255, 0, 0, 10), -1);
+    CHECK_EQUAL(led_strip_particles_count(particles), 2);
+
+    led_strip_particles_clear(particles);
+    CHECK_EQUAL(led_strip_particles_count(particles), 0);
+
+    led_strip_particles_destroy(particles);
+}
+
+static void test_motion(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_particles_t * particles = led_strip_particles_create(4, LEDS);
+
+    // One LED per update from LED 2
+    led_strip_particles_spawn(particles, 2 * ONE, ONE, 200, 0, 0, 100);
+    for (int i = 0; i < 3; i++) {
+        led_strip_particles_update(particles);
+    }
+    led_strip_clear(strip);
+    led_strip_particles_render(particles, strip);
+    CHECK_EQUAL(red_of(strip, 5), 200);
+    CHECK_EQUAL(lit(strip), 1);
+
+    // Half way between two LEDs it is split between them
+    led_strip_particles_clear(particles);
+    led_strip_particles_spawn(particles, 7 * ONE + ONE / 2, 0, 200, 0, 0, 100);
+    led_strip_clear(strip);
+    led_strip_particles_render(particles, strip);
+    CHECK_EQUAL(red_of(strip, 7), 100);
+    CHECK_EQUAL(red_of(strip, 8), 100);
+    CHECK_EQUAL(lit(strip), 2);
+
+    // A second particle on the same LED adds up to 255
+    led_strip_particles_spawn(particles, 7 * ONE + ONE / 2, 0, 200, 0, 0, 100);
+    led_strip_clear(strip);
+    led_strip_particles_render(particles, strip);
+    CHECK_EQUAL(red_of(strip, 7), 200);
+    led_strip_particles_render(particles, strip);
+    CHECK_EQUAL(red_of(strip, 7), 255);
+
+    // Gravity speeds it up every update
+    led_strip_particles_clear(particles);
+    led_strip_particles_set_forces(particles, ONE / 4, 255, 255);
+    led_strip_particles_spawn(particles, 0, 0, 200, 0, 0, 100);
+    for (int i = 0; i < 4; i++) {
+        led_strip_particles_update(particles);
+    }
+    // 1/4 + 2/4 + 3/4 + 4/4 of an LED
+    led_strip_clear(strip);
+    led_strip_particles_render(particles, strip);
+    CHECK_EQUAL(red_of(strip, 2), 100);
+    CHECK_EQUAL(red_of(strip, 3), 100);
+
+    led_strip_particles_destroy(particles);
+    led_strip_destroy(strip);
+}
+
+static void test_death(void)
+{
+    led_strip_particles_t * particles = led_strip_particles_create(8, LEDS);
+
+    led_strip_particles_spawn(particles, ONE, 0, 255, 0, 0, 3);      // Old age
+    led_strip_particles_spawn(particles, ONE, -ONE, 255, 0, 0, 100); // Off the start
+    led_strip_particles_spawn(particles, (LEDS - 1) * ONE, ONE, 255, 0, 0, 100); // Off the end
+    led_strip_particles_spawn(particles, 5 * ONE, 0, 255, 0, 0, 100); // Stays
+
+    led_strip_particles_update(particles);
+    CHECK_EQUAL(led_strip_particles_count(particles), 3);
+    led_strip_particles_update(particles);
+    CHECK_EQUAL(led_strip_particles_count(particles), 2);
+    led_strip_particles_update(particles);
+    CHECK_EQUAL(led_strip_particles_count(particles), 1);
+
+    // Fading out kills it too
+    led_strip_particles_set_forces(particles, 0, 255, 0);
+    led_strip_particles_update(particles);
+    CHECK_EQUAL(led_strip_particles_count(particles), 0);
+
+    led_strip_particles_destroy(particles);
+}
+
+static void test_reversed_view(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 4, 10, 1);
+    led_strip_particles_t * particles = led_strip_particles_create(4, 10);
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    // Pixel 0 of the view is the last LED of its range, and the half of a
+    // particle past the end of the view is not drawn
+    led_strip_particles_spawn(particles, 0, 0, 200, 0, 0, 100);
+    led_strip_particles_spawn(particles, 9 * ONE + ONE / 2, 0, 200, 0, 0, 100);
+    // The LED after the one it is on is one lower in the parent
+    led_strip_particles_spawn(particles, 5 * ONE + ONE / 2, 0, 200, 0, 0, 100);
+    led_strip_particles_render(particles, view);
+
+    CHECK_EQUAL(red_of(strip, 4 + 9), 200);
+    CHECK_EQUAL(red_of(strip, 4), 100);
+    CHECK_EQUAL(red_of(strip, 4 + 9 - 5), 100);
+    CHECK_EQUAL(red_of(strip, 4 + 9 - 6), 100);
+    CHECK_EQUAL(lit(strip), 4);
+
+    uint32_t tracked = led_strip_power_estimate_ma(strip);
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+
+    led_strip_particles_destroy(particles);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_spawn();
+    test_motion();
+    test_death();
+    test_reversed_view();
+
+    return led_strip_test_result("led_strip_test_particles");
+}
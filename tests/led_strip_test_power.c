@@ -0,0 +1,207 @@
+/*
+@file led_strip_test_power.c
+
+@brief Checks that the current estimate follows every way of changing pixels,
+       also through views, and that enabling or disabling it on a strip with
+       views is safe.
+*/
+#include "led_strip_test.h"
+#include "led_strip_power.h"
+#include "led_strip_view.h"
+#include "led_strip_math.h"
+#include "led_strip_calibration.h"
+
+// The estimate recomputed from the pixels of the whole strip
+static uint32_t expected_ma(led_strip_t * strip)
+{
+    uint64_t weighted = 0;
+    uint32_t num_leds = strip->num_leds;
+
+    for (uint32_t p = 0; p < num_leds; p++) {
+        uint8_t r, g, b, brightness;
+        led_strip_get_pixel_color_and_brightness(strip, p, &r, &g, &b, &brightness);
+        weighted += (uint64_t) (r + g + b) * brightness;
+    }
+
+    uint64_t color_ua = weighted * LED_STRIP_POWER_DEFAULT_CHANNEL_UA / (255 * PIXEL_MAX_BRIGHTNESS);
+    uint64_t idle_ua = (uint64_t) num_leds * LED_STRIP_POWER_DEFAULT_IDLE_UA;
+
+    return (uint32_t) ((idle_ua + color_ua) / 1000);
+}
+
+static void test_changes_are_tracked(void)
+{
+    led_strip_t * strip = led_strip_test_create(40, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 10, 20, 1);
+
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    led_strip_set_pixel_color_and_brightness(strip, 3, 255, 10, 20, 31);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    led_strip_set_pixel_color_and_brightness(view, 0, 100, 200, 50, 16);
+    led_strip_set_pixel_brightness(view, 5, 7);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+    CHECK_EQUAL(led_strip_power_estimate_ma(view), expected_ma(strip));
+
+    led_strip_push_pixel_front(view, 1, 2, 3, 31);
+    led_strip_push_pixel_back(strip, 200, 200, 200, 20);
+    led_strip_rotate_left(view);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    // A fill through a view only covers part of the sums
+    led_strip_set_color_and_brightness(view, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    led_strip_scale_range(view, 2, 10, 128);
+    led_strip_blend_range(strip, 0, 40, 0, 255, 0, 64);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+
+    // Only the strip itself estimates
+    CHECK_EQUAL(led_strip_power_enable(view, NULL, 0), -1);
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_view_created_before_enable(void)
+{
+    led_strip_t * strip = led_strip_test_create(16, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 4, 8, 0);
+
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    led_strip_set_pixel_color_and_brightness(view, 1, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+    CHECK(led_strip_power_estimate_ma(strip) > 16);
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_disable_and_enable_with_views(void)
+{
+    led_strip_t * strip = led_strip_test_create(16, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 0, 8, 0);
+    led_strip_t * nested = led_strip_view_create(view, 2, 4, 1);
+
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    // Changes after disabling must not touch the freed estimate
+    led_strip_power_disable(strip);
+    led_strip_set_pixel_color(view, 1, 255, 0, 0);
+    led_strip_set_pixel_color(nested, 1, 0, 255, 0);
+    CHECK_EQUAL(led_strip_power_estimate_ma(view), 0);
+
+    // Enabling again replaces the estimate, and the views use the new one
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 1000), 0);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    led_strip_set_pixel_color_and_brightness(nested, 0, 10, 20, 30, 31);
+    led_strip_set_pixel_color_and_brightness(view, 7, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), expected_ma(strip));
+    CHECK_EQUAL(led_strip_power_estimate_ma(nested), expected_ma(strip));
+
+    // Disabling through a view does nothing
+    led_strip_power_disable(nested);
+    CHECK(led_strip_power_estimate_ma(strip) != 0);
+
+    led_strip_destroy(nested);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_limit(void)
+{
+    led_strip_t * strip = led_strip_test_create(10, &led_strip_protocol_apa102);
+
+    led_strip_set_color_and_brightness(strip, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), 610);
+
+    // Under the budget the pixels are sent as they are
+    led_strip_power_set_budget(strip, 1000);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_power_get_scale(strip), LED_STRIP_POWER_SCALE_NONE);
+    CHECK_EQUAL(led_strip_test_wire[4 + 3], 255);
+
+    // Over it every color is scaled by the same factor, the pixels stay
+    led_strip_power_set_budget(strip, 310);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_power_get_scale(strip), 128);
+    for (uint32_t p = 0; p < 10; p++) {
+        CHECK_EQUAL(led_strip_test_wire[4 + 4*p + 0], 0xFF);
+        CHECK_EQUAL(led_strip_test_wire[4 + 4*p + 1], 127);
+        CHECK_EQUAL(led_strip_test_wire[4 + 4*p + 3], 127);
+    }
+
+    uint8_t r;
+    led_strip_get_pixel_color_and_brightness(strip, 0, &r, NULL, NULL, NULL);
+    CHECK_EQUAL(r, 255);
+
+    led_strip_destroy(strip);
+
+    // The idle current alone is over the budget, with nothing lit to scale
+    strip = led_strip_test_create(100, &led_strip_protocol_apa102);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 50), 0);
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_power_get_scale(strip), LED_STRIP_POWER_SCALE_NONE);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), 100);
+
+    led_strip_destroy(strip);
+}
+
+// The scale is folded into the calibration tables and the WS2801 encoder
+static void test_limit_folded(void)
+{
+    led_strip_t * strip = led_strip_test_create(10, &led_strip_protocol_apa102);
+    uint8_t dim[256];
+
+    for (uint32_t i = 0; i < 256; i++) {
+        dim[i] = (uint8_t) (i / 2);
+    }
+
+    led_strip_set_color_and_brightness(strip, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 310), 0);
+    CHECK_EQUAL(led_strip_calibration_set_tables(strip, dim, dim, dim), 0);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_test_wire[4 + 1], 63);
+
+    // A change of the budget must redo the scaled tables
+    led_strip_power_set_budget(strip, 0);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_test_wire[4 + 1], 127);
+
+    led_strip_calibration_disable(strip);
+    led_strip_destroy(strip);
+
+    strip = led_strip_test_create(10, &led_strip_protocol_ws2801);
+    led_strip_set_color_and_brightness(strip, 255, 255, 255, 31);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 310), 0);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_test_wire_len, 30);
+    for (uint32_t i = 0; i < 30; i++) {
+        CHECK_EQUAL(led_strip_test_wire[i], 127);
+    }
+
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_show(strip), 0);
+    CHECK_EQUAL(led_strip_test_wire[0], 255);
+
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_changes_are_tracked();
+    test_view_created_before_enable();
+    test_disable_and_enable_with_views();
+    test_limit();
+    test_limit_folded();
+
+    return led_strip_test_result("led_strip_test_power");
+}
@@ -0,0 +1,161 @@
+/*
+@file led_strip_test_scatter.c
+
+@brief Checks that scattered updates set the same pixels as setting them one
+       by one, also on reversed views and when sorted, and that the changes
+       they report and count towards the power estimate are the right ones.
+*/
+#include "led_strip_test.h"
+#include "led_strip_scatter.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#define LEDS 300
+#define UPDATES 500
+
+static uint32_t random_state = 1;
+
+static uint32_t random_next(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+// Updates with repeated indices, so the order they are applied in matters
+static void make_updates(led_strip_update_t * updates, uint32_t count, uint32_t num_leds)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        updates[i].p = random_next() % num_leds;
+        updates[i].r = (uint8_t) random_next();
+        updates[i].g = (uint8_t) random_next();
+        updates[i].b = (uint8_t) random_next();
+        updates[i].brightness = (uint8_t) (random_next() % (PIXEL_MAX_BRIGHTNESS + 1));
+    }
+}
+
+static void test_same_as_set_pixel(uint32_t offset, uint32_t length, int reversed, int sort)
+{
+    static led_strip_update_t updates[UPDATES];
+    static led_strip_update_t scratch[UPDATES];
+    led_strip_t * expected = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * actual = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * expected_view = led_strip_view_create(expected, offset, length, reversed);
+    led_strip_t * actual_view = led_strip_view_create(actual, offset, length, reversed);
+
+    make_updates(updates, UPDATES, length);
+    for (uint32_t i = 0; i < UPDATES; i++) {
+        led_strip_set_pixel_color_and_brightness(expected_view, updates[i].p, updates[i].r,
+                                                 updates[i].g, updates[i].b,
+                                                 updates[i].brightness);
+    }
+    CHECK_EQUAL(led_strip_scatter(actual_view, updates, UPDATES, sort ? scratch : NULL, NULL), 0);
+
+    CHECK(memcmp(expected->pixels, actual->pixels, LEDS * sizeof(uint32_t)) == 0);
+
+    led_strip_destroy(actual_view);
+    led_strip_destroy(expected_view);
+    led_strip_destroy(actual);
+    led_strip_destroy(expected);
+}
+
+static void test_invalid_index(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 100, 50, 1);
+    led_strip_update_t updates[2] = {
+        { 3, 255, 255, 255, PIXEL_MAX_BRIGHTNESS },
+        { 50, 255, 255, 255, PIXEL_MAX_BRIGHTNESS },
+    };
+    led_strip_scatter_changes_t changes;
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_scatter(view, updates, 2, NULL, &changes), -1);
+    CHECK_EQUAL(changes.count, 0);
+    CHECK_EQUAL(changes.end, 0);
+
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(view, 3, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 0);
+    CHECK_EQUAL(g, 0);
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_changes(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 0, LEDS, 1);
+    led_strip_update_t updates[4] = {
+        { 40, 255, 0, 0, PIXEL_MAX_BRIGHTNESS },
+        { 7, 0, 0, 0, PIXEL_MAX_BRIGHTNESS },
+        { 200, 0, 255, 0, 4 },
+        { 40, 255, 0, 0, PIXEL_MAX_BRIGHTNESS },
+    };
+    led_strip_scatter_changes_t changes;
+
+    // Clearing already set pixel 7 to this, and the second write to 40 repeats
+    // the first
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_scatter(view, updates, 4, NULL, &changes), 0);
+    CHECK_EQUAL(changes.count, 2);
+    CHECK_EQUAL(changes.first, 40);
+    CHECK_EQUAL(changes.end, 201);
+
+    // The range is by the indices of the view, not where the parent stores them
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, LEDS - 1 - 200, &r, &g, &b, &brightness);
+    CHECK_EQUAL(g, 255);
+    CHECK_EQUAL(brightness, 4);
+
+    CHECK_EQUAL(led_strip_scatter(view, updates, 4, NULL, &changes), 0);
+    CHECK_EQUAL(changes.count, 0);
+    CHECK_EQUAL(changes.first, 0);
+    CHECK_EQUAL(changes.end, 0);
+
+    CHECK_EQUAL(led_strip_scatter(view, updates, 0, NULL, &changes), 0);
+    CHECK_EQUAL(changes.count, 0);
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_power(int sort)
+{
+    static led_strip_update_t updates[UPDATES];
+    static led_strip_update_t scratch[UPDATES];
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 20, 200, 1);
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    for (int round = 0; round < 3; round++) {
+        make_updates(updates, UPDATES, 200);
+        CHECK_EQUAL(led_strip_scatter(view, updates, UPDATES, sort ? scratch : NULL, NULL), 0);
+    }
+    uint32_t tracked = led_strip_power_estimate_ma(strip);
+
+    // Enabling again counts every pixel from scratch
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK(tracked > 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    for (int sort = 0; sort < 2; sort++) {
+        test_same_as_set_pixel(0, LEDS, 0, sort);
+        test_same_as_set_pixel(0, LEDS, 1, sort);
+        test_same_as_set_pixel(37, 100, 1, sort);
+        test_power(sort);
+    }
+    test_invalid_index();
+    test_changes();
+
+    return led_strip_test_result("led_strip_test_scatter");
+}
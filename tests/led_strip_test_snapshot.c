@@ -0,0 +1,158 @@
+/*
+@file led_strip_test_snapshot.c
+
+@brief Checks that snapshots keep the state they saved while the strip and
+       the snapshots sharing chunks with them change, that restoring updates
+       the power estimate, and that pixels are saved by index on reversed
+       views.
+*/
+#include "led_strip_test.h"
+#include "led_strip_snapshot.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+// Not a multiple of the chunk size, so the last chunk is partly used
+#define LEDS (3 * LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 10)
+
+static void draw(led_strip_t * strip, uint8_t seed)
+{
+    for (uint32_t p = 0; p < strip->num_leds; p++) {
+        led_strip_set_pixel_color_and_brightness(strip, p, (uint8_t) (p + seed), (uint8_t) p,
+                                                 seed, (uint8_t) ((p + seed) % 32));
+    }
+}
+
+static int matches(led_strip_t * strip, uint8_t seed)
+{
+    for (uint32_t p = 0; p < strip->num_leds; p++) {
+        uint8_t r, g, b, brightness;
+        led_strip_get_pixel_color_and_brightness(strip, p, &r, &g, &b, &brightness);
+        if (r != (uint8_t) (p + seed) || g != (uint8_t) p || b != seed ||
+            brightness != (p + seed) % 32) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void test_copy_on_write(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    // The second save shares every chunk but the one that changed
+    draw(strip, 1);
+    led_strip_snapshot_t * first = led_strip_snapshot_save(strip);
+    led_strip_set_pixel_color(strip, LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5, 9, 9, 9);
+    led_strip_snapshot_t * second = led_strip_snapshot_save(strip);
+    CHECK(first != NULL);
+    CHECK(second != NULL);
+
+    // Changing the strip after saving changes neither
+    draw(strip, 2);
+    CHECK_EQUAL(led_strip_snapshot_restore(strip, first), 0);
+    CHECK(matches(strip, 1));
+
+    CHECK_EQUAL(led_strip_snapshot_restore(strip, second), 0);
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5,
+                                             &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 9);
+    led_strip_set_pixel_color(strip, LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5,
+                              (uint8_t) (LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5 + 1),
+                              (uint8_t) (LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5), 1);
+    CHECK(matches(strip, 1));
+
+    // The chunks the first shares with the second outlive it
+    led_strip_snapshot_destroy(first);
+    draw(strip, 3);
+    led_strip_snapshot_t * third = led_strip_snapshot_save(strip);
+    CHECK_EQUAL(led_strip_snapshot_restore(strip, second), 0);
+    led_strip_get_pixel_color_and_brightness(strip, LED_STRIP_SNAPSHOT_CHUNK_PIXELS + 5,
+                                             &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 9);
+    CHECK_EQUAL(matches(strip, 1), 0);
+    led_strip_snapshot_destroy(second);
+    CHECK_EQUAL(led_strip_snapshot_restore(strip, third), 0);
+    CHECK(matches(strip, 3));
+
+    // Only a strip of the same length can be restored
+    led_strip_t * other = led_strip_test_create(LEDS - 1, &led_strip_protocol_apa102);
+    CHECK_EQUAL(led_strip_snapshot_restore(other, third), -1);
+    led_strip_destroy(other);
+
+    led_strip_snapshot_destroy(third);
+    led_strip_destroy(strip);
+}
+
+static void test_power(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS + 20, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 20, LEDS, 0);
+
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    uint32_t dark = led_strip_power_estimate_ma(strip);
+
+    draw(view, 7);
+    led_strip_snapshot_t * snapshot = led_strip_snapshot_save(view);
+    led_strip_clear(strip);
+    CHECK_EQUAL(led_strip_power_estimate_ma(strip), dark);
+
+    // Restoring through the view counts towards the estimate of its parent
+    CHECK_EQUAL(led_strip_snapshot_restore(view, snapshot), 0);
+    uint32_t tracked = led_strip_power_estimate_ma(strip);
+    CHECK(tracked > dark);
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+
+    led_strip_snapshot_destroy(snapshot);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+static void test_reversed_view(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS + 8, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 5, LEDS, 1);
+    led_strip_t * plain = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    led_strip_clear(strip);
+    // Saved by index, so it reads the same from pixel 0 on either strip
+    draw(view, 4);
+    led_strip_snapshot_t * snapshot = led_strip_snapshot_save(view);
+    CHECK_EQUAL(led_strip_snapshot_restore(plain, snapshot), 0);
+    CHECK(matches(plain, 4));
+
+    draw(view, 5);
+    CHECK_EQUAL(led_strip_snapshot_restore(view, snapshot), 0);
+    CHECK(matches(view, 4));
+
+    // And back from the plain strip into the reversed view
+    draw(plain, 6);
+    led_strip_snapshot_t * plain_snapshot = led_strip_snapshot_save(plain);
+    CHECK_EQUAL(led_strip_snapshot_restore(view, plain_snapshot), 0);
+    CHECK(matches(view, 6));
+
+    // Restoring does not reach past the range of the view
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, 4, &r, &g, &b, &brightness);
+    CHECK_EQUAL(b, 0);
+    led_strip_get_pixel_color_and_brightness(strip, 5 + LEDS, &r, &g, &b, &brightness);
+    CHECK_EQUAL(b, 0);
+
+    led_strip_snapshot_destroy(plain_snapshot);
+    led_strip_snapshot_destroy(snapshot);
+    led_strip_destroy(plain);
+    led_strip_destroy(view);
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_copy_on_write();
+    test_power();
+    test_reversed_view();
+
+    return led_strip_test_result("led_strip_test_snapshot");
+}
@@ -0,0 +1,224 @@
+/*
+@file led_strip_test_view.c
+
+@brief Checks that every function of led_strip.h does the same on a view as
+       on a strip of its length, also on reversed and nested views, without
+       touching the pixels of the parent outside the range, and that views
+       show through their parent.
+*/
+#include "led_strip_test.h"
+#include "led_strip_view.h"
+#include "led_strip_power.h"
+
+#define LEDS 64
+#define ROUNDS 500
+
+static uint32_t random_state = 1;
+
+static uint32_t random_next(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+// Apply one random function to both strips
+static void random_op(led_strip_t * view, led_strip_t * expected)
+{
+    uint32_t p = random_next() % (expected->num_leds + 2);
+    uint8_t r = (uint8_t) random_next();
+    uint8_t g = (uint8_t) random_next();
+    uint8_t b = (uint8_t) random_next();
+    uint8_t brightness = (uint8_t) (random_next() % (PIXEL_MAX_BRIGHTNESS + 1));
+    uint8_t rgb[3 * 8];
+
+    switch (random_next() % 10) {
+    case 0:
+        led_strip_set_pixel_color_and_brightness(view, p, r, g, b, brightness);
+        led_strip_set_pixel_color_and_brightness(expected, p, r, g, b, brightness);
+        break;
+    case 1:
+        led_strip_set_pixel_color(view, p, r, g, b);
+        led_strip_set_pixel_color(expected, p, r, g, b);
+        break;
+    case 2:
+        led_strip_set_pixel_brightness(view, p, brightness);
+        led_strip_set_pixel_brightness(expected, p, brightness);
+        break;
+    case 3:
+        for (uint32_t i = 0; i < sizeof(rgb); i++) {
+            rgb[i] = (uint8_t) random_next();
+        }
+        led_strip_set_pixels_rgb(view, p, sizeof(rgb) / 3, rgb, brightness);
+        led_strip_set_pixels_rgb(expected, p, sizeof(rgb) / 3, rgb, brightness);
+        break;
+    case 4:
+        led_strip_set_color(view, r, g, b);
+        led_strip_set_color(expected, r, g, b);
+        break;
+    case 5:
+        led_strip_set_brightness(view, brightness);
+        led_strip_set_brightness(expected, brightness);
+        break;
+    case 6:
+        led_strip_push_pixel_front(view, r, g, b, brightness);
+        led_strip_push_pixel_front(expected, r, g, b, brightness);
+        break;
+    case 7:
+        led_strip_push_pixel_back(view, r, g, b, brightness);
+        led_strip_push_pixel_back(expected, r, g, b, brightness);
+        break;
+    case 8:
+        led_strip_rotate_left(view);
+        led_strip_rotate_left(expected);
+        break;
+    default:
+        led_strip_rotate_right(view);
+        led_strip_rotate_right(expected);
+        break;
+    }
+}
+
+static uint32_t differences(led_strip_t * view, led_strip_t * expected)
+{
+    uint32_t count = 0;
+
+    for (uint32_t p = 0; p < expected->num_leds; p++) {
+        uint8_t r, g, b, brightness;
+        uint8_t expected_r, expected_g, expected_b, expected_brightness;
+        led_strip_get_pixel_color_and_brightness(view, p, &r, &g, &b, &brightness);
+        led_strip_get_pixel_color_and_brightness(expected, p, &expected_r, &expected_g,
+                                                 &expected_b, &expected_brightness);
+        count += (r != expected_r || g != expected_g || b != expected_b ||
+                  brightness != expected_brightness);
+    }
+    return count;
+}
+
+static void test_same_as_strip(uint32_t offset, uint32_t length, int reversed,
+                               uint32_t inner_offset, uint32_t inner_length, int inner_reversed)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * outer = led_strip_view_create(strip, offset, length, reversed);
+    led_strip_t * view = led_strip_view_create(outer, inner_offset, inner_length, inner_reversed);
+    led_strip_t * expected = led_strip_test_create(inner_length, &led_strip_protocol_apa102);
+
+    CHECK(view != NULL);
+    if (view == NULL) {
+        return;
+    }
+
+    // Every pixel of the parent is different, so a write outside the range shows
+    for (uint32_t p = 0; p < LEDS; p++) {
+        led_strip_set_pixel_color_and_brightness(strip, p, (uint8_t) p, 1, 2, 3);
+    }
+    uint32_t before[LEDS];
+    memcpy(before, strip->pixels, sizeof(before));
+
+    led_strip_clear(view);
+    led_strip_clear(expected);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        random_op(view, expected);
+        CHECK_EQUAL(differences(view, expected), 0);
+    }
+
+    // The range of the view in the parent, from its offsets and directions
+    uint32_t first = reversed ? offset + length - inner_offset - inner_length
+                              : offset + inner_offset;
+    uint32_t outside = 0;
+    for (uint32_t p = 0; p < LEDS; p++) {
+        outside += (p < first || p >= first + inner_length) && strip->pixels[p] != before[p];
+    }
+    CHECK_EQUAL(outside, 0);
+
+    uint32_t tracked = led_strip_power_estimate_ma(strip);
+    led_strip_power_disable(strip);
+    CHECK_EQUAL(led_strip_power_enable(strip, NULL, 0), 0);
+    CHECK_EQUAL(tracked, led_strip_power_estimate_ma(strip));
+
+    led_strip_destroy(expected);
+    led_strip_destroy(view);
+    led_strip_destroy(outer);
+    led_strip_destroy(strip);
+}
+
+static void test_nested_index(void)
+{
+    led_strip_t * strip = led_strip_test_create(20, &led_strip_protocol_apa102);
+    led_strip_t * outer = led_strip_view_create(strip, 5, 10, 1);
+    led_strip_t * inner = led_strip_view_create(outer, 2, 4, 1);
+
+    // Reversed twice is in the order of the parent again: pixel 0 of inner is
+    // pixel 5 of outer, which is LED 5 + 9 - 5 of the parent
+    led_strip_clear(strip);
+    led_strip_set_pixel_color(inner, 0, 10, 0, 0);
+    led_strip_set_pixel_color(inner, 3, 13, 0, 0);
+
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, 9, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 10);
+    led_strip_get_pixel_color_and_brightness(strip, 12, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 13);
+
+    led_strip_destroy(inner);
+    led_strip_destroy(outer);
+    led_strip_destroy(strip);
+}
+
+static void test_create_errors(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+
+    CHECK(led_strip_view_create(strip, 0, 0, 0) == NULL);
+    CHECK(led_strip_view_create(strip, LEDS, 1, 0) == NULL);
+    CHECK(led_strip_view_create(strip, 1, LEDS, 0) == NULL);
+    CHECK(led_strip_view_create(strip, 10, 0xFFFFFFFF - 5, 0) == NULL);
+
+    led_strip_t * view = led_strip_view_create(strip, LEDS - 1, 1, 1);
+    CHECK(view != NULL);
+    if (view) {
+        led_strip_destroy(view);
+    }
+
+    led_strip_destroy(strip);
+}
+
+static void test_show(void)
+{
+    led_strip_t * strip = led_strip_test_create(LEDS, &led_strip_protocol_apa102);
+    led_strip_t * view = led_strip_view_create(strip, 8, 8, 1);
+
+    // Showing the view sends the whole parent in one transfer
+    led_strip_clear(strip);
+    led_strip_set_pixel_color(view, 0, 77, 0, 0);
+    uint32_t shows = led_strip_test_shows;
+    CHECK_EQUAL(led_strip_show(view), 0);
+    CHECK_EQUAL(led_strip_test_shows, shows + 1);
+    CHECK_EQUAL(led_strip_test_wire_len, strip->header_len + strip->tx_len + strip->footer_len);
+    CHECK_EQUAL(led_strip_test_wire[4 + 4 * 15 + 3], 77);
+
+    // Destroying the view leaves the pixels of the parent
+    led_strip_destroy(view);
+    uint8_t r, g, b, brightness;
+    led_strip_get_pixel_color_and_brightness(strip, 15, &r, &g, &b, &brightness);
+    CHECK_EQUAL(r, 77);
+
+    led_strip_destroy(strip);
+}
+
+int main(void)
+{
+    test_same_as_strip(0, LEDS, 0, 0, LEDS, 0);
+    test_same_as_strip(0, LEDS, 1, 0, LEDS, 0);
+    test_same_as_strip(5, 40, 0, 3, 30, 0);
+    test_same_as_strip(5, 40, 1, 3, 30, 0);
+    test_same_as_strip(5, 40, 0, 3, 30, 1);
+    test_same_as_strip(5, 40, 1, 3, 30, 1);
+    test_same_as_strip(20, 1, 1, 0, 1, 1);
+    test_nested_index();
+    test_create_errors();
+    test_show();
+
+    return led_strip_test_result("led_strip_test_view");
+}